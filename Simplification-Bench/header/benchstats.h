@@ -0,0 +1,48 @@
+/*  What the benchmark measures around every phase: wall time, the heap allocations made (counted by
+	replacing the global operator new of the benchmark executable), the peak resident memory and, when they
+	are open, the hardware counters (see hwcounters.h).
+*/
+
+#ifndef BENCHSTATS_H
+#define BENCHSTATS_H
+
+#include "hwcounters.h"
+
+#include <chrono>
+#include <cstddef>
+
+struct PhaseStats
+{
+	double ms;
+	double msSpread; //median absolute deviation of the repetitions
+	unsigned long long allocations;
+	unsigned long long allocatedBytes;
+	unsigned long long counters[HARDWARE_COUNTERS]; //0 when they aren't open
+
+	PhaseStats() { ms = msSpread = 0; allocations = allocatedBytes = 0; for (int i = 0; i < HARDWARE_COUNTERS; i++) counters[i] = 0; }
+};
+
+//started on construction, stop fills the stats of everything since then
+class PhaseProbe
+{
+public:
+	PhaseProbe();
+	void stop(PhaseStats &stats) const;
+
+private:
+	std::chrono::high_resolution_clock::time_point start;
+	unsigned long long allocations;
+	unsigned long long allocatedBytes;
+	unsigned long long counters[HARDWARE_COUNTERS];
+};
+
+//operator new calls and the bytes asked for since the program started, from every thread
+unsigned long long allocationCount();
+unsigned long long allocatedBytes();
+
+//highest resident set size of the process in bytes. On Linux resetPeakRSS starts a new peak from the current
+//size, elsewhere the peak can't be reset and covers the whole process
+size_t peakRSS();
+void resetPeakRSS();
+
+#endif
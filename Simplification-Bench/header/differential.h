@@ -0,0 +1,48 @@
+/*  Differential check of the fast contraction engine against the reference one (edgeContraction).
+	Both simplify a copy of the same mesh to the same ratio and the results are measured against the input:
+	 + the live triangles left, the fast engine has to get as close to the target
+	 + the quadric error: the squared distances of every input vertex to the planes of its triangles, taken at
+	   the closest point of the result and summed, the same measure for both engines whatever they minimize
+	 + the symmetric Hausdorff distance between the input and the result, sampled (see meshdistance.h)
+	A case fails when the fast engine is worse than the reference by more than the tolerance, or its Hausdorff
+	distance is over the bound of the case. The bound is what still checks the fast engine where the reference
+	goes wrong (it tears open borders and falls apart on lightning.obj) or is too slow to run.
+*/
+
+#ifndef DIFFERENTIAL_H
+#define DIFFERENTIAL_H
+
+#include <string>
+
+class MeshData;
+
+struct SimplifiedQuality
+{
+	unsigned long long triangles;
+	double ms;
+	double quadricError;
+	double hausdorff;
+};
+
+struct DifferentialResult
+{
+	std::string name;
+	float ratio;
+	unsigned long long target; //triangles
+	double diagonal; //of the bounding box of the input, the distances are absolute
+	double maxHausdorff; //bound on the fast engine, a fraction of the diagonal, 0 for none
+	bool withReference; //false when only the fast engine ran
+	SimplifiedQuality reference;
+	SimplifiedQuality fast;
+	bool passed;
+};
+
+//all but the time
+void measureQuality(const MeshData &original, const MeshData &simplified, SimplifiedQuality &quality);
+
+//loaded only needs its geometry. tolerance is a fraction, 0.05 lets the fast engine be 5% worse.
+//maxHausdorff is a fraction of the diagonal (0 for none), without the reference it is all the fast engine is held to
+void compareEngines(const MeshData &loaded, float ratio, double tolerance, double maxHausdorff, bool withReference,
+	DifferentialResult &result);
+
+#endif
@@ -0,0 +1,34 @@
+/*  Hardware performance counters around the benchmark phases, through perf_event_open on Linux.
+	 + Every counter is opened on its own, one the CPU or the kernel doesn't offer is left out and the rest still count
+	 + Only user space is counted, which is what perf_event_paranoid 2 (the usual default) allows
+	 + The threads started after opening them are counted too once they finish, like the loader's thread pools
+	 + When the kernel has to multiplex them the values are scaled by the time they actually ran
+	Elsewhere, or in containers without access to perf events, none open and the benchmark carries on without them.
+*/
+
+#ifndef HWCOUNTERS_H
+#define HWCOUNTERS_H
+
+#include <string>
+
+enum HardwareCounter
+{
+	COUNTER_CYCLES,
+	COUNTER_INSTRUCTIONS,
+	COUNTER_L1D_MISSES,		//L1 data cache read misses
+	COUNTER_LLC_MISSES,		//last level cache read misses
+	COUNTER_BRANCH_MISSES,
+	HARDWARE_COUNTERS
+};
+
+const char* hardwareCounterName(int counter);
+
+//false if none of them could be opened, error says why
+bool openHardwareCounters(std::string &error);
+bool hardwareCounterOpen(int counter);
+bool hardwareCountersOpen();
+
+//totals since they were opened, 0 for the ones that aren't
+void readHardwareCounters(unsigned long long values[HARDWARE_COUNTERS]);
+
+#endif
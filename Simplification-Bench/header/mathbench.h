@@ -0,0 +1,22 @@
+/*  Microbenchmarks of the Matrix44 and Vector4 kernels (see mathkernels.h): every kernel set the CPU
+	supports is timed on the same inputs and its results are compared bit for bit with the scalar ones.
+*/
+
+#ifndef MATHBENCH_H
+#define MATHBENCH_H
+
+#include <string>
+#include <vector>
+
+struct MathBenchResult
+{
+	std::string kernels;
+	std::string op;
+	double nsPerOp;
+	bool exact;		//same bits as the scalar kernel on every input
+};
+
+//false if some kernel differs from the scalar one
+bool runMathBenchmarks(std::vector<MathBenchResult> &results);
+
+#endif
@@ -0,0 +1,19 @@
+/*  Regression gate of the benchmark: the results of a run are checked against the JSON file of an earlier one.
+	 + Meshes are matched by name and ratios by value, the ones missing from either file are only listed. A mesh
+	   that loaded in the baseline and fails now is a regression
+	 + Times are medians of the repetitions, a phase regresses when it is slower than the baseline by more than
+	   the threshold plus three times the spread of the repetitions (ms_mad) of either run, and a small floor for
+	   the timer. Run both with -n 5 or more so the spread means something
+	 + Allocations, the memory tracked per structure and the peak resident memory regress past the threshold alone
+	 + A different number of triangles out means the simplification changed, the times can't be compared and it
+	   fails too
+*/
+
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+//prints every regression, returns how many there are or -1 if the files can't be read or don't match
+//(other engine or index width). threshold is a fraction, 0.1 lets a phase be 10% slower
+int checkBaseline(const char* baselineFile, const char* currentFile, double threshold);
+
+#endif
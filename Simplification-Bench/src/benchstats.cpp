@@ -0,0 +1,112 @@
+#include "benchstats.h"
+
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+	#pragma comment(lib, "psapi.lib")
+#else
+	#include <sys/resource.h>
+#endif
+
+static std::atomic<unsigned long long> s_allocations(0);
+static std::atomic<unsigned long long> s_allocatedBytes(0);
+
+//the array and nothrow forms end up here too
+void* operator new(size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	void* p = malloc(size ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+unsigned long long allocationCount()
+{
+	return s_allocations.load(std::memory_order_relaxed);
+}
+
+unsigned long long allocatedBytes()
+{
+	return s_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+PhaseProbe::PhaseProbe()
+{
+	allocations = allocationCount();
+	allocatedBytes = ::allocatedBytes();
+	readHardwareCounters(counters);
+	start = std::chrono::high_resolution_clock::now();
+}
+
+void PhaseProbe::stop(PhaseStats &stats) const
+{
+	stats.ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	unsigned long long now[HARDWARE_COUNTERS];
+	readHardwareCounters(now);
+	for (int i = 0; i < HARDWARE_COUNTERS; i++)
+		stats.counters[i] = now[i] > counters[i] ? now[i] - counters[i] : 0;
+	stats.allocations = allocationCount() - allocations;
+	stats.allocatedBytes = ::allocatedBytes() - allocatedBytes;
+}
+
+size_t peakRSS()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	//VmHWM follows resetPeakRSS, ru_maxrss doesn't
+	FILE* f = fopen("/proc/self/status", "r");
+	if (f != NULL)
+	{
+		char line[256];
+		size_t kb = 0;
+		while (fgets(line, sizeof(line), f))
+		{
+			if (strncmp(line, "VmHWM:", 6) == 0)
+			{
+				kb = (size_t)strtoull(line + 6, NULL, 10);
+				break;
+			}
+		}
+		fclose(f);
+		if (kb)
+			return kb * 1024;
+	}
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
+
+void resetPeakRSS()
+{
+#ifndef _WIN32
+	FILE* f = fopen("/proc/self/clear_refs", "w");
+	if (f == NULL)
+		return;
+	fputs("5", f);
+	fclose(f);
+#endif
+}
@@ -0,0 +1,145 @@
+#include "differential.h"
+#include "meshdata.h"
+#include "bvh.h"
+#include "meshdistance.h"
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+static void addBounds(const MeshData &mesh, DVector3 &min, DVector3 &max)
+{
+	for (size_t v = 0; v < mesh.indexed_positions.size(); v++)
+	{
+		DVector3 p(mesh.indexed_positions[v]);
+		min = DVector3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+		max = DVector3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+	}
+}
+
+void measureQuality(const MeshData &original, const MeshData &simplified, SimplifiedQuality &quality)
+{
+	quality.triangles = 0;
+	for (size_t t = 0; t < simplified.triangles.size(); t++)
+		if (simplified.isLiveTriangle(simplified.triangles[t]))
+			quality.triangles++;
+
+	TriangleBVH originalBVH, simplifiedBVH;
+	originalBVH.build(original);
+	simplifiedBVH.build(simplified);
+
+	//the planes of the input triangles around every input vertex
+	size_t numVertices = original.indexed_positions.size();
+	std::vector<double> planes; //normal and d, 4 per plane
+	std::vector<size_t> offsets(numVertices + 1, 0);
+	for (size_t t = 0; t < original.triangles.size(); t++)
+	{
+		const Triangle &tri = original.triangles[t];
+		if (!original.isLiveTriangle(tri))
+			continue;
+		offsets[tri.i + 1]++;
+		offsets[tri.j + 1]++;
+		offsets[tri.k + 1]++;
+	}
+	for (size_t v = 0; v < numVertices; v++)
+		offsets[v + 1] += offsets[v];
+	planes.resize(offsets[numVertices] * 4);
+	std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t t = 0; t < original.triangles.size(); t++)
+	{
+		const Triangle &tri = original.triangles[t];
+		if (!original.isLiveTriangle(tri))
+			continue;
+		DVector3 a(original.indexed_positions[tri.i]);
+		DVector3 normal = (DVector3(original.indexed_positions[tri.j]) - a).cross(DVector3(original.indexed_positions[tri.k]) - a);
+		double length = sqrt(normal.dot(normal));
+		if (length > 0)
+			normal = normal * (1 / length);
+		const MeshIndex vertices[3] = { tri.i, tri.j, tri.k };
+		for (int k = 0; k < 3; k++)
+		{
+			double* plane = &planes[fill[vertices[k]]++ * 4];
+			plane[0] = normal.x;
+			plane[1] = normal.y;
+			plane[2] = normal.z;
+			plane[3] = -normal.dot(a);
+		}
+	}
+
+	quality.quadricError = 0;
+	DVector3 closest;
+	MeshIndex triangle;
+	for (size_t v = 0; v < numVertices; v++)
+	{
+		if (offsets[v] == offsets[v + 1] || !simplifiedBVH.closest(DVector3(original.indexed_positions[v]), closest, triangle))
+			continue;
+		for (size_t i = offsets[v]; i < offsets[v + 1]; i++)
+		{
+			const double* plane = &planes[i * 4];
+			double distance = plane[0] * closest.x + plane[1] * closest.y + plane[2] * closest.z + plane[3];
+			quality.quadricError += distance * distance;
+		}
+	}
+
+	//one thread, the cases run one after the other and are small
+	DistanceOptions options;
+	options.threads = 1;
+	DistanceStats forward, backward;
+	measureOneSided(original, simplifiedBVH, options, forward);
+	measureOneSided(simplified, originalBVH, options, backward);
+	quality.hausdorff = std::max(forward.hausdorff, backward.hausdorff);
+}
+
+static double simplifyCopy(const MeshData &loaded, float ratio, SimplifyEngine engine, MeshData &mesh)
+{
+	mesh.verbose = false;
+	loaded.copyGeometry(mesh);
+	SimplifyOptions options;
+	options.target_ratio = ratio;
+	options.engine = engine;
+	//the reference builds its topology inside, the fast engine its own structures
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	mesh.simplify(options);
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+//a within tolerance of b, slack is for the values close to 0
+static bool withinTolerance(double a, double b, double tolerance, double slack)
+{
+	return a <= b * (1 + tolerance) + slack;
+}
+
+void compareEngines(const MeshData &loaded, float ratio, double tolerance, double maxHausdorff, bool withReference,
+	DifferentialResult &result)
+{
+	result.ratio = ratio;
+	result.target = (MeshIndex)(loaded.triangles.size() * (double)ratio);
+	DVector3 min(DBL_MAX, DBL_MAX, DBL_MAX), max(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+	addBounds(loaded, min, max);
+	result.diagonal = loaded.indexed_positions.empty() ? 0 : sqrt((max - min).dot(max - min));
+	result.maxHausdorff = maxHausdorff;
+	result.withReference = withReference;
+
+	MeshData reference, fast;
+	result.fast.ms = simplifyCopy(loaded, ratio, SIMPLIFY_FAST, fast);
+	measureQuality(loaded, fast, result.fast);
+	double target = (double)result.target;
+	result.passed = maxHausdorff <= 0 || result.fast.hausdorff <= maxHausdorff * result.diagonal;
+	if (!withReference)
+	{
+		result.reference.triangles = 0;
+		result.reference.ms = result.reference.quadricError = result.reference.hausdorff = 0;
+		result.passed = result.passed && fabs(result.fast.triangles - target) <= target * tolerance + 2;
+		return;
+	}
+	result.reference.ms = simplifyCopy(loaded, ratio, SIMPLIFY_REFERENCE, reference);
+	measureQuality(loaded, reference, result.reference);
+
+	//the reference may stop short of the target, the fast engine can't be further from it
+	double epsilon = 1e-6 * result.diagonal;
+	result.passed = result.passed &&
+		fabs(result.fast.triangles - target) <= fabs(result.reference.triangles - target) + target * tolerance + 2 &&
+		withinTolerance(result.fast.quadricError, result.reference.quadricError, tolerance, epsilon * epsilon * loaded.indexed_positions.size()) &&
+		withinTolerance(result.fast.hausdorff, result.reference.hausdorff, tolerance, epsilon);
+}
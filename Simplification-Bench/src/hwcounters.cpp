@@ -0,0 +1,104 @@
+#include "hwcounters.h"
+
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+	#include <linux/perf_event.h>
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+static const char* s_counterNames[HARDWARE_COUNTERS] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+static int s_counterFiles[HARDWARE_COUNTERS] = { -1, -1, -1, -1, -1 };
+
+const char* hardwareCounterName(int counter)
+{
+	return s_counterNames[counter];
+}
+
+bool hardwareCounterOpen(int counter)
+{
+	return s_counterFiles[counter] >= 0;
+}
+
+bool hardwareCountersOpen()
+{
+	for (int i = 0; i < HARDWARE_COUNTERS; i++)
+		if (s_counterFiles[i] >= 0)
+			return true;
+	return false;
+}
+
+#ifdef __linux__
+
+static int openCounter(unsigned int type, unsigned long long config)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.inherit = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+	//this process and its threads, on any cpu
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static unsigned long long cacheMisses(unsigned long long cache)
+{
+	return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+bool openHardwareCounters(std::string &error)
+{
+	s_counterFiles[COUNTER_CYCLES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+	//the first one tells if perf events are there at all
+	int firstError = errno;
+	s_counterFiles[COUNTER_INSTRUCTIONS] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+	s_counterFiles[COUNTER_L1D_MISSES] = openCounter(PERF_TYPE_HW_CACHE, cacheMisses(PERF_COUNT_HW_CACHE_L1D));
+	s_counterFiles[COUNTER_LLC_MISSES] = openCounter(PERF_TYPE_HW_CACHE, cacheMisses(PERF_COUNT_HW_CACHE_LL));
+	s_counterFiles[COUNTER_BRANCH_MISSES] = openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+	if (hardwareCountersOpen())
+		return true;
+
+	if (firstError == EACCES || firstError == EPERM)
+		error = "no permission for perf events, see /proc/sys/kernel/perf_event_paranoid";
+	else if (firstError == ENOSYS)
+		error = "perf events are not supported by the kernel or blocked by the container";
+	else if (firstError == ENOENT || firstError == EOPNOTSUPP)
+		error = "the CPU doesn't expose these counters";
+	else error = strerror(firstError);
+	return false;
+}
+
+void readHardwareCounters(unsigned long long values[HARDWARE_COUNTERS])
+{
+	for (int i = 0; i < HARDWARE_COUNTERS; i++)
+	{
+		//value, time enabled, time running
+		unsigned long long data[3];
+		values[i] = 0;
+		if (s_counterFiles[i] < 0 || read(s_counterFiles[i], data, sizeof(data)) != (ssize_t)sizeof(data))
+			continue;
+		values[i] = data[2] > 0 && data[2] < data[1] ? (unsigned long long)((double)data[0] * data[1] / data[2]) : data[0];
+	}
+}
+
+#else
+
+bool openHardwareCounters(std::string &error)
+{
+	error = "hardware counters are only read on Linux";
+	return false;
+}
+
+void readHardwareCounters(unsigned long long values[HARDWARE_COUNTERS])
+{
+	for (int i = 0; i < HARDWARE_COUNTERS; i++)
+		values[i] = 0;
+}
+
+#endif
@@ -0,0 +1,659 @@
+/*  Benchmark of the simplification pipeline over the bundled meshes.
+	 + Every mesh is loaded (or generated, for shape:triangles[:seed] arguments), then for every ratio a copy of it gets its topology built (setup) and is
+	   contracted to the ratio of its triangles (collapse)
+	 + Every phase reports its wall time, the heap allocations it made, the peak resident memory and the
+	   memory of every mesh structure (see memorystats.h)
+	 + The median of -n repetitions is kept, the results go to a JSON file to compare runs against
+	 + --counters adds the hardware counters of every phase, IPC and the misses per collapse (see hwcounters.h)
+	 + --baseline checks the results against the JSON file of an earlier run (see regression.h)
+	 + The fast contraction engine is timed, --reference times the reference one instead
+	 + --math times the matrix kernels instead (see mathbench.h)
+	 + --compare checks the fast engine against the reference one instead (see differential.h)
+*/
+
+#include "meshdata.h"
+#include "meshgenerator.h"
+#include "trace.h"
+#include "memorystats.h"
+#include "benchstats.h"
+#include "mathbench.h"
+#include "mathkernels.h"
+#include "differential.h"
+#include "regression.h"
+#include "hwcounters.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <sys/stat.h>
+
+static const char* s_defaultMeshes[] = { "sphere.obj", "lamp.obj", "capsule.obj", "lee.obj", "lightning.obj" };
+//the reference engine is O(n^2), lightning alone would take it tens of minutes
+static const char* s_defaultReferenceMeshes[] = { "sphere.obj", "lamp.obj", "capsule.obj", "lee.obj" };
+struct CompareCase
+{
+	std::string mesh;
+	float ratio;			//0: every ratio of -r
+	double maxHausdorff;	//% of the diagonal the fast engine has to stay under, 0 for none
+	bool withReference;
+};
+
+//the reference engine is O(n^2), the comparison sticks to small meshes. It also tears the borders of terrain open
+//and falls apart on lightning, so there the fast engine is held to bounds of its own, 1.5 to 2 times what it
+//gets today. Lightning is too big for the reference past the first collapses, its worst ratios run the fast
+//engine alone
+static const CompareCase s_compareCases[] = {
+	{ "sphere.obj", 0, 0, true },
+	{ "lamp.obj", 0, 0, true },
+	{ "sphere:2000", 0, 0, true },
+	{ "terrain:2000", 0, 1.5, true },
+	{ "torus:2000", 0, 0, true },
+	{ "scan:2000", 0, 0, true },
+	{ "lightning.obj", 0.98f, 0.4, true },
+	{ "lightning.obj", 0.5f, 7.5, false },
+	{ "lightning.obj", 0.25f, 12, false }
+};
+//where the data folder is from the solution, the project folders and the output folders
+static const char* s_dataDirs[] = { "data", "../Surface-Simplification/data", "Surface-Simplification/data", "../../Surface-Simplification/data" };
+
+struct RatioResult
+{
+	float ratio;
+	unsigned long long trianglesOut;
+	unsigned long long collapses;
+	PhaseStats setup;
+	PhaseStats collapse;
+	size_t peakRSS;
+	std::vector<MemoryTracker::Phase> memory;
+};
+
+struct MeshResult
+{
+	std::string name;
+	bool ok;
+	unsigned long long trianglesIn;
+	unsigned long long vertices;
+	PhaseStats load;
+	size_t peakRSS;
+	std::vector<MemoryTracker::Phase> memory;
+	std::vector<RatioResult> ratios;
+};
+
+//"terrain:1000000:7" -> a synthetic mesh, see meshgenerator.h
+static bool parseSynthetic(const std::string &arg, MeshShape &shape, unsigned long long &triangles, unsigned int &seed)
+{
+	size_t colon = arg.find(':');
+	if (colon == std::string::npos || !parseMeshShape(arg.substr(0, colon).c_str(), shape))
+		return false;
+	char* end;
+	triangles = strtoull(arg.c_str() + colon + 1, &end, 10);
+	seed = *end == ':' ? (unsigned int)strtoul(end + 1, NULL, 10) : 1;
+	return triangles > 0;
+}
+
+static bool fileExists(const std::string &path)
+{
+	struct stat st;
+	return stat(path.c_str(), &st) == 0;
+}
+
+static std::string baseName(const std::string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+//a mesh argument, a file (looked up in the data folder first) or a synthetic shape
+struct MeshSource
+{
+	std::string name;
+	std::string path;
+	bool synthetic;
+	MeshShape shape;
+	unsigned long long triangles;
+	unsigned int seed;
+};
+
+static MeshSource resolveMesh(const std::string &arg, const std::string &dataDir)
+{
+	MeshSource source;
+	source.path = !dataDir.empty() && fileExists(dataDir + "/" + arg) ? dataDir + "/" + arg : arg;
+	source.shape = SHAPE_SPHERE;
+	source.triangles = 0;
+	source.seed = 1;
+	source.synthetic = !fileExists(source.path) && parseSynthetic(arg, source.shape, source.triangles, source.seed);
+	source.name = source.synthetic ? arg : baseName(source.path);
+	return source;
+}
+
+static bool loadMesh(const MeshSource &source, MeshData &mesh)
+{
+	return source.synthetic ? generateMesh(source.shape, source.triangles, source.seed, mesh) : mesh.load(source.path.c_str());
+}
+
+//"0.75,0.5,0.25" -> {0.75, 0.5, 0.25}
+static std::vector<float> parseRatios(const char* text)
+{
+	std::vector<float> ratios;
+	while (*text)
+	{
+		char* end;
+		float r = (float)strtod(text, &end);
+		if (end == text)
+			break;
+		ratios.push_back(r);
+		text = *end == ',' ? end + 1 : end;
+	}
+	return ratios;
+}
+
+static double median(std::vector<double> &values)
+{
+	std::sort(values.begin(), values.end());
+	size_t middle = values.size() / 2;
+	return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+//the repetitions of a phase reduced to the median time and its spread, allocations don't change between them
+static PhaseStats median(std::vector<PhaseStats> &samples)
+{
+	std::vector<double> times;
+	for (size_t i = 0; i < samples.size(); i++)
+		times.push_back(samples[i].ms);
+	PhaseStats result = samples[0];
+	result.ms = median(times);
+	for (size_t i = 0; i < times.size(); i++)
+		times[i] = std::fabs(times[i] - result.ms);
+	result.msSpread = median(times);
+	for (int c = 0; c < HARDWARE_COUNTERS; c++)
+	{
+		for (size_t i = 0; i < samples.size(); i++)
+			times[i] = (double)samples[i].counters[c];
+		result.counters[c] = (unsigned long long)median(times);
+	}
+	return result;
+}
+
+static std::string jsonString(const std::string &text)
+{
+	std::string out = "\"";
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		if (text[i] == '"' || text[i] == '\\')
+			out += '\\';
+		out += text[i];
+	}
+	return out + "\"";
+}
+
+static void writePhase(FILE* f, const char* name, const PhaseStats &stats, const char* indent)
+{
+	fprintf(f, "%s\"%s\": { \"ms\": %.3f, \"ms_mad\": %.3f, \"allocations\": %llu, \"allocated_bytes\": %llu", indent, name, stats.ms,
+		stats.msSpread, stats.allocations, stats.allocatedBytes);
+	if (hardwareCountersOpen())
+	{
+		fprintf(f, ",\n%s  \"counters\": {", indent);
+		const char* separator = " ";
+		for (int i = 0; i < HARDWARE_COUNTERS; i++)
+		{
+			if (!hardwareCounterOpen(i))
+				continue;
+			fprintf(f, "%s\"%s\": %llu", separator, hardwareCounterName(i), stats.counters[i]);
+			separator = ", ";
+		}
+		fprintf(f, " }");
+	}
+	fprintf(f, " }");
+}
+
+static void writeMemory(FILE* f, const std::vector<MemoryTracker::Phase> &phases, const char* indent)
+{
+	fprintf(f, "%s\"memory\": [\n", indent);
+	for (size_t p = 0; p < phases.size(); p++)
+	{
+		const MemoryTracker::Phase &phase = phases[p];
+		fprintf(f, "%s  { \"phase\": %s, \"live_bytes\": %llu, \"peak_bytes\": %llu,\n%s    \"live\": {", indent, jsonString(phase.name).c_str(),
+			(unsigned long long)phase.live.total(), (unsigned long long)phase.peakTotal, indent);
+		for (int i = 0; i < MEMORY_STRUCTURES; i++)
+			fprintf(f, "%s\"%s\": %llu", i ? ", " : " ", memoryStructureName(i), (unsigned long long)phase.live.bytes[i]);
+		fprintf(f, " },\n%s    \"peak\": {", indent);
+		for (int i = 0; i < MEMORY_STRUCTURES; i++)
+			fprintf(f, "%s\"%s\": %llu", i ? ", " : " ", memoryStructureName(i), (unsigned long long)phase.peak.bytes[i]);
+		fprintf(f, " } }%s\n", p + 1 < phases.size() ? "," : "");
+	}
+	fprintf(f, "%s]", indent);
+}
+
+static size_t peakTracked(const std::vector<MemoryTracker::Phase> &phases)
+{
+	size_t peak = 0;
+	for (size_t p = 0; p < phases.size(); p++)
+		peak = std::max(peak, phases[p].peakTotal);
+	return peak;
+}
+
+//IPC and the misses, per collapse when there are collapses
+static void printCounters(const char* phase, const PhaseStats &stats, unsigned long long collapses)
+{
+	if (!hardwareCountersOpen())
+		return;
+	char line[512];
+	int length = snprintf(line, sizeof(line), "    %-8s IPC %5.2f", phase, stats.counters[COUNTER_CYCLES] ?
+		(double)stats.counters[COUNTER_INSTRUCTIONS] / stats.counters[COUNTER_CYCLES] : 0.0);
+	for (int i = COUNTER_INSTRUCTIONS; i < HARDWARE_COUNTERS && length < (int)sizeof(line); i++)
+	{
+		if (!hardwareCounterOpen(i))
+			continue;
+		if (collapses)
+			length += snprintf(line + length, sizeof(line) - length, "  %10.1f %s/collapse", (double)stats.counters[i] / collapses, hardwareCounterName(i));
+		else length += snprintf(line + length, sizeof(line) - length, "  %12llu %s", stats.counters[i], hardwareCounterName(i));
+	}
+	std::cout << line << std::endl;
+}
+
+static bool writeJSON(const char* filename, const std::vector<MeshResult> &results, unsigned int repetitions, SimplifyEngine engine)
+{
+	FILE* f = fopen(filename, "w");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << filename << std::endl;
+		return false;
+	}
+
+	fprintf(f, "{\n  \"version\": 1,\n  \"index_bits\": %u,\n  \"engine\": \"%s\",\n  \"repetitions\": %u,\n  \"meshes\": [\n",
+		(unsigned int)(sizeof(MeshIndex) * 8), engine == SIMPLIFY_FAST ? "fast" : "reference", repetitions);
+	for (size_t m = 0; m < results.size(); m++)
+	{
+		const MeshResult &r = results[m];
+		fprintf(f, "    {\n      \"name\": %s,\n      \"ok\": %s,\n      \"triangles\": %llu,\n      \"vertices\": %llu,\n",
+			jsonString(r.name).c_str(), r.ok ? "true" : "false", r.trianglesIn, r.vertices);
+		writePhase(f, "load", r.load, "      ");
+		fprintf(f, ",\n      \"load_peak_rss_bytes\": %llu,\n", (unsigned long long)r.peakRSS);
+		writeMemory(f, r.memory, "      ");
+		fprintf(f, ",\n      \"ratios\": [\n");
+		for (size_t i = 0; i < r.ratios.size(); i++)
+		{
+			const RatioResult &rr = r.ratios[i];
+			double seconds = rr.collapse.ms / 1000.0;
+			fprintf(f, "        {\n          \"ratio\": %g,\n          \"triangles_out\": %llu,\n          \"collapses\": %llu,\n"
+				"          \"collapses_per_sec\": %.1f,\n", rr.ratio, rr.trianglesOut, rr.collapses, seconds > 0 ? rr.collapses / seconds : 0.0);
+			writePhase(f, "setup", rr.setup, "          ");
+			fprintf(f, ",\n");
+			writePhase(f, "collapse", rr.collapse, "          ");
+			if (hardwareCountersOpen())
+			{
+				const unsigned long long* counters = rr.collapse.counters;
+				fprintf(f, ",\n          \"collapse_ipc\": %.3f,\n          \"per_collapse\": {", counters[COUNTER_CYCLES] ?
+					(double)counters[COUNTER_INSTRUCTIONS] / counters[COUNTER_CYCLES] : 0.0);
+				const char* separator = " ";
+				for (int c = 0; c < HARDWARE_COUNTERS; c++)
+				{
+					if (!hardwareCounterOpen(c))
+						continue;
+					fprintf(f, "%s\"%s\": %.2f", separator, hardwareCounterName(c), rr.collapses ? (double)counters[c] / rr.collapses : 0.0);
+					separator = ", ";
+				}
+				fprintf(f, " }");
+			}
+			fprintf(f, ",\n          \"peak_rss_bytes\": %llu,\n", (unsigned long long)rr.peakRSS);
+			writeMemory(f, rr.memory, "          ");
+			fprintf(f, "\n        }%s\n", i + 1 < r.ratios.size() ? "," : "");
+		}
+		fprintf(f, "      ]\n    }%s\n", m + 1 < results.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+
+	bool ok = !ferror(f);
+	if (fclose(f) != 0 || !ok)
+	{
+		std::cerr << "Error writing file: " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+static int runMath(const std::string &output)
+{
+	std::vector<MathBenchResult> results;
+	bool exact = runMathBenchmarks(results);
+
+	std::cout << "kernels in use: " << g_mathKernels->name << std::endl;
+	char line[256];
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		snprintf(line, sizeof(line), "%-10s %-8s %8.2f ns/op  %s", results[i].op.c_str(), results[i].kernels.c_str(), results[i].nsPerOp,
+			results[i].exact ? "exact" : "DIFFERS FROM SCALAR");
+		std::cout << line << std::endl;
+	}
+
+	FILE* f = fopen(output.c_str(), "w");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << output << std::endl;
+		return 1;
+	}
+	fprintf(f, "{\n  \"version\": 1,\n  \"kernels\": %s,\n  \"math\": [\n", jsonString(g_mathKernels->name).c_str());
+	for (size_t i = 0; i < results.size(); i++)
+		fprintf(f, "    { \"op\": %s, \"kernels\": %s, \"ns_per_op\": %.3f, \"exact\": %s }%s\n", jsonString(results[i].op).c_str(),
+			jsonString(results[i].kernels).c_str(), results[i].nsPerOp, results[i].exact ? "true" : "false", i + 1 < results.size() ? "," : "");
+	fprintf(f, "  ]\n}\n");
+	bool ok = !ferror(f);
+	if (fclose(f) != 0 || !ok)
+	{
+		std::cerr << "Error writing file: " << output << std::endl;
+		return 1;
+	}
+	std::cout << "Results written to " << output << std::endl;
+	return exact ? 0 : 1;
+}
+
+static int runCompare(const std::vector<CompareCase> &cases, const std::string &dataDir, const std::vector<float> &ratios, double tolerance,
+	const std::string &output)
+{
+	std::vector<DifferentialResult> results;
+	unsigned int failed = 0;
+	char line[512];
+	MeshData loaded;
+	std::string loadedName;
+	for (size_t c = 0; c < cases.size(); c++)
+	{
+		//the cases of a mesh are next to each other, it is loaded once for all of them
+		MeshSource source = resolveMesh(cases[c].mesh, dataDir);
+		if (loadedName != cases[c].mesh)
+		{
+			loadedName.clear();
+			loaded.clear();
+			loaded.verbose = false;
+			if (!loadMesh(source, loaded))
+			{
+				failed++;
+				snprintf(line, sizeof(line), "%-16s FAIL", source.name.c_str());
+				std::cout << line << std::endl;
+				continue;
+			}
+			//only the geometry is copied for each engine
+			loaded.dropTopology();
+			loadedName = cases[c].mesh;
+		}
+
+		std::vector<float> caseRatios = cases[c].ratio > 0 ? std::vector<float>(1, cases[c].ratio) : ratios;
+		for (size_t i = 0; i < caseRatios.size(); i++)
+		{
+			DifferentialResult r;
+			r.name = source.name;
+			compareEngines(loaded, caseRatios[i], tolerance, cases[c].maxHausdorff / 100, cases[c].withReference, r);
+			if (!r.passed)
+				failed++;
+			results.push_back(r);
+
+			double diagonal = r.diagonal > 0 ? r.diagonal : 1;
+			char bound[32] = "";
+			if (r.maxHausdorff > 0)
+				snprintf(bound, sizeof(bound), "  (max %g%%)", 100 * r.maxHausdorff);
+			if (r.withReference)
+				snprintf(line, sizeof(line), "%-16s ratio %4.2f  tris %8llu / %8llu  quadric %10.4g / %10.4g  hausdorff %7.4f%% / %7.4f%%  %10.2f / %8.2f ms  %s%s",
+					r.name.c_str(), r.ratio, r.reference.triangles, r.fast.triangles, r.reference.quadricError, r.fast.quadricError,
+					100 * r.reference.hausdorff / diagonal, 100 * r.fast.hausdorff / diagonal, r.reference.ms, r.fast.ms, r.passed ? "ok" : "FAIL", bound);
+			else snprintf(line, sizeof(line), "%-16s ratio %4.2f  tris %8s / %8llu  quadric %10s / %10.4g  hausdorff %8s / %7.4f%%  %10s / %8.2f ms  %s%s",
+					r.name.c_str(), r.ratio, "-", r.fast.triangles, "-", r.fast.quadricError, "-", 100 * r.fast.hausdorff / diagonal, "-", r.fast.ms,
+					r.passed ? "ok" : "FAIL", bound);
+			std::cout << line << std::endl;
+		}
+	}
+
+	FILE* f = fopen(output.c_str(), "w");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << output << std::endl;
+		return 1;
+	}
+	fprintf(f, "{\n  \"version\": 1,\n  \"tolerance\": %g,\n  \"compare\": [\n", tolerance);
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const DifferentialResult &r = results[i];
+		const SimplifiedQuality* engines[2] = { &r.reference, &r.fast };
+		fprintf(f, "    { \"name\": %s, \"ratio\": %g, \"target\": %llu, \"diagonal\": %.9g, \"max_hausdorff\": %.9g, \"passed\": %s", jsonString(r.name).c_str(),
+			r.ratio, r.target, r.diagonal, r.maxHausdorff * r.diagonal, r.passed ? "true" : "false");
+		for (int e = r.withReference ? 0 : 1; e < 2; e++)
+			fprintf(f, ",\n      \"%s\": { \"triangles\": %llu, \"ms\": %.3f, \"quadric_error\": %.9g, \"hausdorff\": %.9g }", e ? "fast" : "reference",
+				engines[e]->triangles, engines[e]->ms, engines[e]->quadricError, engines[e]->hausdorff);
+		fprintf(f, " }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	bool ok = !ferror(f);
+	if (fclose(f) != 0 || !ok)
+	{
+		std::cerr << "Error writing file: " << output << std::endl;
+		return 1;
+	}
+	std::cout << results.size() << " cases, " << failed << " failed, results written to " << output << std::endl;
+	return failed ? 1 : 0;
+}
+
+static void printUsage()
+{
+	std::cout << "usage: benchmark [options] [mesh]..." << std::endl
+		<< "  meshes are looked up in the data folder, by default sphere, lamp, capsule, lee and lightning (not with --reference)" << std::endl
+		<< "  shape:triangles[:seed] generates a sphere, terrain, torus or scan mesh instead of loading it" << std::endl
+		<< "  -d, --data DIR      folder of the meshes (default: the viewer's data folder)" << std::endl
+		<< "  -r, --ratios R1,..  fractions of the triangles to keep, each one from the loaded mesh (default 0.75,0.5,0.25)" << std::endl
+		<< "  -n N                repetitions, the median is reported (default 1)" << std::endl
+		<< "  -o, --output FILE   JSON results (default benchmark.json, math.json with --math, compare.json with --compare)" << std::endl
+		<< "  --trace FILE        write the phases and counters as Chrome trace events (needs SIMPLIFICATION_TRACE)" << std::endl
+		<< "  --counters          read the hardware counters of every phase, report IPC and misses per collapse (Linux)" << std::endl
+		<< "  --reference         time the reference contraction engine instead of the fast one (--fast, the default)" << std::endl
+		<< "  --math              time the scalar, SSE and AVX matrix kernels and check they match instead" << std::endl
+		<< "  --compare           check the fast engine against the reference one instead, fails if it is worse" << std::endl
+		<< "                      (default meshes sphere, lamp, the four synthetic shapes at 2000 triangles and lightning with" << std::endl
+		<< "                      Hausdorff bounds on the fast engine, see s_compareCases)" << std::endl
+		<< "  --tolerance PCT     how much worse the fast engine may be in --compare (default 5)" << std::endl
+		<< "  --baseline FILE     check the results against an earlier run, fails if a phase got slower or bigger" << std::endl
+		<< "  --threshold PCT     how much slower or bigger a phase may get against --baseline (default 10)" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	std::string dataDir, output, traceFile, baseline;
+	std::vector<float> ratios;
+	ratios.push_back(0.75f);
+	ratios.push_back(0.5f);
+	ratios.push_back(0.25f);
+	unsigned int repetitions = 1;
+	std::vector<std::string> meshes;
+	bool math = false, compare = false, counters = false;
+	SimplifyEngine engine = SIMPLIFY_FAST;
+	double tolerance = 5, threshold = 10;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if ((arg == "-d" || arg == "--data") && hasValue)
+			dataDir = argv[++i];
+		else if ((arg == "-r" || arg == "--ratios") && hasValue)
+			ratios = parseRatios(argv[++i]);
+		else if (arg == "-n" && hasValue)
+			repetitions = (unsigned int)atoi(argv[++i]);
+		else if ((arg == "-o" || arg == "--output") && hasValue)
+			output = argv[++i];
+		else if (arg == "--trace" && hasValue)
+			traceFile = argv[++i];
+		else if (arg == "--counters")
+			counters = true;
+		else if (arg == "--fast")
+			engine = SIMPLIFY_FAST;
+		else if (arg == "--reference")
+			engine = SIMPLIFY_REFERENCE;
+		else if (arg == "--math")
+			math = true;
+		else if (arg == "--compare")
+			compare = true;
+		else if (arg == "--tolerance" && hasValue)
+			tolerance = atof(argv[++i]);
+		else if (arg == "--baseline" && hasValue)
+			baseline = argv[++i];
+		else if (arg == "--threshold" && hasValue)
+			threshold = atof(argv[++i]);
+		else if (arg == "-h" || arg == "--help")
+		{
+			printUsage();
+			return 0;
+		}
+		else if (arg[0] == '-')
+		{
+			std::cerr << "Unknown option: " << arg << std::endl;
+			printUsage();
+			return 1;
+		}
+		else meshes.push_back(arg);
+	}
+	if (repetitions == 0 || ratios.empty())
+	{
+		printUsage();
+		return 1;
+	}
+	//the modes write their own files, a --math run must not replace the results a --baseline reads
+	if (output.empty())
+		output = math ? "math.json" : (compare ? "compare.json" : "benchmark.json");
+	if (math)
+		return runMath(output);
+
+	//meshes named on the command line are compared at every ratio, without bounds
+	std::vector<CompareCase> cases;
+	for (size_t m = 0; m < meshes.size(); m++)
+	{
+		CompareCase c = { meshes[m], 0, 0, true };
+		cases.push_back(c);
+	}
+	if (cases.empty())
+		cases.assign(s_compareCases, s_compareCases + sizeof(s_compareCases) / sizeof(s_compareCases[0]));
+	if (meshes.empty() && engine == SIMPLIFY_REFERENCE)
+		meshes.assign(s_defaultReferenceMeshes, s_defaultReferenceMeshes + sizeof(s_defaultReferenceMeshes) / sizeof(s_defaultReferenceMeshes[0]));
+	else if (meshes.empty())
+		meshes.assign(s_defaultMeshes, s_defaultMeshes + sizeof(s_defaultMeshes) / sizeof(s_defaultMeshes[0]));
+	if (dataDir.empty())
+	{
+		for (size_t i = 0; i < sizeof(s_dataDirs) / sizeof(s_dataDirs[0]) && dataDir.empty(); i++)
+			if (fileExists(std::string(s_dataDirs[i]) + "/sphere.obj"))
+				dataDir = s_dataDirs[i];
+	}
+	if (compare)
+		return runCompare(cases, dataDir, ratios, tolerance / 100, output);
+
+	if (!traceFile.empty() && !traceStart())
+	{
+		std::cerr << "Tracing is not compiled in, build with SIMPLIFICATION_TRACE defined" << std::endl;
+		return 1;
+	}
+	std::string counterError;
+	if (counters && !openHardwareCounters(counterError))
+		std::cerr << "Hardware counters unavailable, " << counterError << std::endl;
+
+	std::vector<MeshResult> results(meshes.size());
+	unsigned int failed = 0;
+	for (size_t m = 0; m < meshes.size(); m++)
+	{
+		MeshResult &r = results[m];
+		MeshSource source = resolveMesh(meshes[m], dataDir);
+		r.name = source.name;
+		r.ok = true;
+		r.trianglesIn = r.vertices = 0;
+		r.peakRSS = 0;
+
+		std::vector<PhaseStats> loads;
+		std::vector<std::vector<PhaseStats> > setups(ratios.size()), collapses(ratios.size());
+		r.ratios.resize(ratios.size());
+		for (unsigned int rep = 0; rep < repetitions && r.ok; rep++)
+		{
+			//the loaders also build the topology, setup below times it alone on a bare copy.
+			//Synthetic meshes time their generation as the load
+			MeshData loaded;
+			MemoryTracker loadMemory;
+			loaded.verbose = false;
+			loaded.memory = &loadMemory;
+			resetPeakRSS();
+			PhaseProbe loadProbe;
+			r.ok = loadMesh(source, loaded);
+			loads.push_back(PhaseStats());
+			loadProbe.stop(loads.back());
+			r.peakRSS = std::max(r.peakRSS, peakRSS());
+			if (!r.ok)
+				break;
+			r.memory = loadMemory.getPhases();
+			r.trianglesIn = loaded.triangles.size();
+			r.vertices = loaded.indexed_positions.size();
+
+			for (size_t i = 0; i < ratios.size(); i++)
+			{
+				RatioResult &rr = r.ratios[i];
+				MeshData mesh;
+				MemoryTracker memory;
+				mesh.verbose = false;
+				mesh.memory = &memory;
+				loaded.copyGeometry(mesh);
+
+				//the fast engine makes its own structures inside the collapse
+				resetPeakRSS();
+				PhaseProbe setupProbe;
+				if (engine == SIMPLIFY_REFERENCE)
+					mesh.buildTopology();
+				setups[i].push_back(PhaseStats());
+				setupProbe.stop(setups[i].back());
+
+				SimplifyOptions options;
+				options.target_ratio = ratios[i];
+				options.engine = engine;
+				PhaseProbe collapseProbe;
+				rr.trianglesOut = mesh.simplify(options);
+				collapses[i].push_back(PhaseStats());
+				collapseProbe.stop(collapses[i].back());
+
+				rr.ratio = ratios[i];
+				rr.collapses = mesh.collapses;
+				rr.memory = memory.getPhases();
+				rr.peakRSS = rep ? std::max(rr.peakRSS, peakRSS()) : peakRSS();
+			}
+		}
+
+		char line[512];
+		if (!r.ok)
+		{
+			failed++;
+			r.ratios.clear();
+			snprintf(line, sizeof(line), "%-16s FAIL", r.name.c_str());
+			std::cout << line << std::endl;
+			continue;
+		}
+		r.load = median(loads);
+		snprintf(line, sizeof(line), "%-16s %8llu tris  load %9.2f ms  %7llu allocs  peak %7.1f MB  mesh %7.1f MB", r.name.c_str(), r.trianglesIn,
+			r.load.ms, r.load.allocations, r.peakRSS / (1024.0 * 1024.0), peakTracked(r.memory) / (1024.0 * 1024.0));
+		std::cout << line << std::endl;
+		printCounters("load", r.load, 0);
+		for (size_t i = 0; i < ratios.size(); i++)
+		{
+			RatioResult &rr = r.ratios[i];
+			rr.setup = median(setups[i]);
+			rr.collapse = median(collapses[i]);
+			double seconds = rr.collapse.ms / 1000.0;
+			snprintf(line, sizeof(line), "  ratio %4.2f %8llu tris  setup %9.2f ms  collapse %10.2f ms  %10.1f collapses/s  %8llu allocs  peak %7.1f MB  mesh %7.1f MB",
+				rr.ratio, rr.trianglesOut, rr.setup.ms, rr.collapse.ms, seconds > 0 ? rr.collapses / seconds : 0.0,
+				rr.setup.allocations + rr.collapse.allocations, rr.peakRSS / (1024.0 * 1024.0), peakTracked(rr.memory) / (1024.0 * 1024.0));
+			std::cout << line << std::endl;
+			printCounters("setup", rr.setup, 0);
+			printCounters("collapse", rr.collapse, rr.collapses);
+		}
+	}
+
+	if (!traceFile.empty() && !traceWrite(traceFile.c_str()))
+		return 1;
+	if (!writeJSON(output.c_str(), results, repetitions, engine))
+		return 1;
+	std::cout << "Results written to " << output << std::endl;
+	if (!baseline.empty() && checkBaseline(baseline.c_str(), output.c_str(), threshold / 100) != 0)
+		return 1;
+	return failed ? 1 : 0;
+}
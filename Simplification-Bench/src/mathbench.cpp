@@ -0,0 +1,104 @@
+#include "mathbench.h"
+#include "mathkernels.h"
+
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+
+#define MATHBENCH_INPUTS 1024
+#define MATHBENCH_ROUNDS 2000
+
+//a fixed generator so every run times the same inputs
+static float nextFloat(unsigned int &state)
+{
+	state = state * 1664525u + 1013904223u;
+	return (state >> 8) / 16777216.0f * 2 - 1;
+}
+
+//mostly well conditioned matrices, plus the rank one quadrics of flat areas, which take the singular path
+static void makeInputs(std::vector<float> &matrices, std::vector<float> &vectors)
+{
+	unsigned int state = 12345;
+	matrices.resize(MATHBENCH_INPUTS * 16);
+	vectors.resize(MATHBENCH_INPUTS * 4);
+	for (int n = 0; n < MATHBENCH_INPUTS; n++)
+	{
+		float* m = &matrices[n * 16];
+		if (n % 8 == 7)
+		{
+			float p[4] = { nextFloat(state), nextFloat(state), nextFloat(state), nextFloat(state) };
+			for (int i = 0; i < 16; i++)
+				m[i] = p[i / 4] * p[i % 4];
+		}
+		else
+		{
+			for (int i = 0; i < 16; i++)
+				m[i] = nextFloat(state) + (i % 5 == 0 ? 4.0f : 0.0f);
+		}
+		for (int i = 0; i < 4; i++)
+			vectors[n * 4 + i] = nextFloat(state);
+	}
+}
+
+enum { OP_MULTIPLY, OP_ADD, OP_MULTM4XV4, OP_MULTV4XM4, OP_INVERSE, OP_COUNT };
+static const char* s_opNames[OP_COUNT] = { "multiply", "add", "multM4xV4", "multV4xM4", "inverse" };
+
+//runs op over every input, the outputs of the last round end in out
+static void runOp(const MathKernels &k, int op, const std::vector<float> &matrices, const std::vector<float> &vectors, std::vector<float> &out, int rounds)
+{
+	out.assign(MATHBENCH_INPUTS * 16, 0.0f);
+	for (int r = 0; r < rounds; r++)
+	{
+		for (int n = 0; n < MATHBENCH_INPUTS; n++)
+		{
+			const float* a = &matrices[n * 16];
+			const float* b = &matrices[((n + 1) % MATHBENCH_INPUTS) * 16];
+			const float* v = &vectors[n * 4];
+			float* o = &out[n * 16];
+			switch (op)
+			{
+			case OP_MULTIPLY: k.multiply(a, b, o); break;
+			case OP_ADD: k.add(a, b, o); break;
+			case OP_MULTM4XV4: k.multM4xV4(a, v, o); break;
+			case OP_MULTV4XM4: k.multV4xM4(v, a, o); break;
+			default: o[15] = k.inverse(a, o) ? 1.0f : -1.0f; break;
+			}
+		}
+	}
+}
+
+bool runMathBenchmarks(std::vector<MathBenchResult> &results)
+{
+	std::vector<float> matrices, vectors;
+	makeInputs(matrices, vectors);
+
+	std::vector<const MathKernels*> sets;
+	sets.push_back(&scalarMathKernels());
+	if (sseMathKernels())
+		sets.push_back(sseMathKernels());
+	if (avxMathKernels())
+		sets.push_back(avxMathKernels());
+
+	bool allExact = true;
+	std::vector<float> reference, out;
+	for (int op = 0; op < OP_COUNT; op++)
+	{
+		runOp(scalarMathKernels(), op, matrices, vectors, reference, 1);
+		for (size_t s = 0; s < sets.size(); s++)
+		{
+			runOp(*sets[s], op, matrices, vectors, out, 1); //warm up and check
+			MathBenchResult r;
+			r.kernels = sets[s]->name;
+			r.op = s_opNames[op];
+			r.exact = memcmp(&out[0], &reference[0], out.size() * sizeof(float)) == 0;
+			allExact = allExact && r.exact;
+
+			std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+			runOp(*sets[s], op, matrices, vectors, out, MATHBENCH_ROUNDS);
+			double ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+			r.nsPerOp = ns / ((double)MATHBENCH_ROUNDS * MATHBENCH_INPUTS);
+			results.push_back(r);
+		}
+	}
+	return allExact;
+}
@@ -0,0 +1,397 @@
+#include "regression.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+//below this the timer and the scheduler decide, not the code
+#define TIME_FLOOR_MS 0.5
+#define RSS_FLOOR_BYTES (1024.0 * 1024.0)
+#define TIME_SPREADS 3.0
+
+//just what the benchmark writes: objects, arrays, strings, numbers, true, false and null
+struct JsonValue
+{
+	enum Type { JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT };
+
+	Type type;
+	double number; //also the bools
+	std::string text;
+	std::vector<std::string> keys; //of the items of an object
+	std::vector<JsonValue> items;
+
+	JsonValue() { type = JSON_NULL; number = 0; }
+
+	const JsonValue* get(const char* key) const
+	{
+		for (size_t i = 0; i < keys.size(); i++)
+			if (keys[i] == key)
+				return &items[i];
+		return NULL;
+	}
+
+	double getNumber(const char* key, double fallback = 0) const
+	{
+		const JsonValue* value = get(key);
+		return value != NULL && (value->type == JSON_NUMBER || value->type == JSON_BOOL) ? value->number : fallback;
+	}
+
+	std::string getString(const char* key) const
+	{
+		const JsonValue* value = get(key);
+		return value != NULL && value->type == JSON_STRING ? value->text : std::string();
+	}
+};
+
+class JsonReader
+{
+public:
+	JsonReader(const std::string &text) : p(text.c_str()), end(text.c_str() + text.size()) {}
+
+	bool read(JsonValue &value)
+	{
+		return parse(value, 0) && (skipSpace(), p == end);
+	}
+
+private:
+	const char* p;
+	const char* end;
+
+	void skipSpace()
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+			p++;
+	}
+
+	bool literal(const char* word)
+	{
+		const char* q = p;
+		for (; *word; word++, q++)
+			if (q >= end || *q != *word)
+				return false;
+		p = q;
+		return true;
+	}
+
+	bool parseString(std::string &text)
+	{
+		if (p >= end || *p != '"')
+			return false;
+		for (p++; p < end && *p != '"'; p++)
+		{
+			if (*p != '\\')
+			{
+				text += *p;
+				continue;
+			}
+			if (++p >= end)
+				return false;
+			switch (*p)
+			{
+			case 'n': text += '\n'; break;
+			case 't': text += '\t'; break;
+			case 'r': text += '\r'; break;
+			case 'b': text += '\b'; break;
+			case 'f': text += '\f'; break;
+			//the names are only compared, the code point doesn't matter
+			case 'u':
+				if (end - p < 5)
+					return false;
+				text += '?';
+				p += 4;
+				break;
+			default: text += *p;
+			}
+		}
+		if (p >= end)
+			return false;
+		p++;
+		return true;
+	}
+
+	bool parse(JsonValue &value, int depth)
+	{
+		skipSpace();
+		if (p >= end || depth > 64)
+			return false;
+		if (*p == '{' || *p == '[')
+		{
+			bool object = *p == '{';
+			char close = object ? '}' : ']';
+			value.type = object ? JsonValue::JSON_OBJECT : JsonValue::JSON_ARRAY;
+			p++;
+			skipSpace();
+			if (p < end && *p == close)
+			{
+				p++;
+				return true;
+			}
+			while (true)
+			{
+				skipSpace();
+				if (object)
+				{
+					value.keys.push_back(std::string());
+					if (!parseString(value.keys.back()))
+						return false;
+					skipSpace();
+					if (p >= end || *p != ':')
+						return false;
+					p++;
+				}
+				value.items.push_back(JsonValue());
+				if (!parse(value.items.back(), depth + 1))
+					return false;
+				skipSpace();
+				if (p < end && *p == ',')
+					p++;
+				else if (p < end && *p == close)
+				{
+					p++;
+					return true;
+				}
+				else return false;
+			}
+		}
+		if (*p == '"')
+		{
+			value.type = JsonValue::JSON_STRING;
+			return parseString(value.text);
+		}
+		if (literal("true"))
+		{
+			value.type = JsonValue::JSON_BOOL;
+			value.number = 1;
+			return true;
+		}
+		if (literal("false"))
+		{
+			value.type = JsonValue::JSON_BOOL;
+			return true;
+		}
+		if (literal("null"))
+			return true;
+		//the text is null terminated, strtod stops there at most
+		char* after;
+		value.number = strtod(p, &after);
+		if (after == p)
+			return false;
+		value.type = JsonValue::JSON_NUMBER;
+		p = after;
+		return true;
+	}
+};
+
+static bool readJSON(const char* filename, JsonValue &root)
+{
+	FILE* f = fopen(filename, "rb");
+	if (f == NULL)
+	{
+		std::cerr << "File not found: " << filename << std::endl;
+		return false;
+	}
+	std::string text;
+	char buffer[65536];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		text.append(buffer, read);
+	fclose(f);
+
+	JsonReader reader(text);
+	if (!reader.read(root) || root.type != JsonValue::JSON_OBJECT || root.get("meshes") == NULL)
+	{
+		std::cerr << "Invalid benchmark results: " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+//of every structure together, the highest of the phases
+static double trackedPeak(const JsonValue &owner)
+{
+	const JsonValue* memory = owner.get("memory");
+	double peak = 0;
+	if (memory != NULL)
+		for (size_t i = 0; i < memory->items.size(); i++)
+			peak = std::max(peak, memory->items[i].getNumber("peak_bytes"));
+	return peak;
+}
+
+class BaselineCheck
+{
+public:
+	BaselineCheck(double threshold) : threshold(threshold), regressions(0), improvements(0), compared(0) {}
+
+	//where a regression happened, "lamp.obj" or "lamp.obj ratio 0.50"
+	std::string where;
+	double threshold;
+	unsigned int regressions;
+	unsigned int improvements;
+	unsigned int compared;
+
+	void report(const char* metric, double before, double after, const char* verdict)
+	{
+		char line[512];
+		snprintf(line, sizeof(line), "%-28s %-22s %14.3f -> %14.3f  %+7.1f%%  %s", where.c_str(), metric, before, after,
+			before > 0 ? 100 * (after - before) / before : 0.0, verdict);
+		std::cout << line << std::endl;
+	}
+
+	//allowed is how far above the baseline the value can go
+	void check(const char* metric, double before, double after, double allowed)
+	{
+		compared++;
+		if (after > before + allowed)
+		{
+			regressions++;
+			report(metric, before, after, "REGRESSION");
+		}
+		else if (after < before - allowed)
+			improvements++;
+	}
+
+	void checkPhase(const char* name, const JsonValue &before, const JsonValue &after)
+	{
+		const JsonValue* b = before.get(name);
+		const JsonValue* a = after.get(name);
+		if (b == NULL || a == NULL)
+			return;
+		std::string metric = name;
+		double beforeMs = b->getNumber("ms"), afterMs = a->getNumber("ms");
+		double spread = std::max(b->getNumber("ms_mad"), a->getNumber("ms_mad"));
+		check((metric + " ms").c_str(), beforeMs, afterMs, beforeMs * threshold + TIME_SPREADS * spread + TIME_FLOOR_MS);
+		double allocations = b->getNumber("allocations");
+		check((metric + " allocations").c_str(), allocations, a->getNumber("allocations"), allocations * threshold);
+		double bytes = b->getNumber("allocated_bytes");
+		check((metric + " allocated bytes").c_str(), bytes, a->getNumber("allocated_bytes"), bytes * threshold);
+	}
+
+	void checkMemory(const char* rssKey, const JsonValue &before, const JsonValue &after)
+	{
+		double rss = before.getNumber(rssKey);
+		if (rss > 0 && after.getNumber(rssKey) > 0)
+			check("peak rss bytes", rss, after.getNumber(rssKey), rss * threshold + RSS_FLOOR_BYTES);
+		double tracked = trackedPeak(before);
+		check("mesh peak bytes", tracked, trackedPeak(after), tracked * threshold);
+	}
+};
+
+static const JsonValue* findMesh(const JsonValue &meshes, const std::string &name)
+{
+	for (size_t i = 0; i < meshes.items.size(); i++)
+		if (meshes.items[i].getString("name") == name)
+			return &meshes.items[i];
+	return NULL;
+}
+
+static const JsonValue* findRatio(const JsonValue &mesh, double ratio)
+{
+	const JsonValue* ratios = mesh.get("ratios");
+	if (ratios != NULL)
+		for (size_t i = 0; i < ratios->items.size(); i++)
+			if (std::fabs(ratios->items[i].getNumber("ratio", -1) - ratio) < 1e-4)
+				return &ratios->items[i];
+	return NULL;
+}
+
+int checkBaseline(const char* baselineFile, const char* currentFile, double threshold)
+{
+	JsonValue baseline, current;
+	if (!readJSON(baselineFile, baseline) || !readJSON(currentFile, current))
+		return -1;
+	//older results don't say, they were all the reference engine
+	std::string baselineEngine = baseline.get("engine") != NULL ? baseline.getString("engine") : "reference";
+	std::string currentEngine = current.get("engine") != NULL ? current.getString("engine") : "reference";
+	if (baselineEngine != currentEngine || baseline.getNumber("index_bits") != current.getNumber("index_bits"))
+	{
+		std::cerr << "The baseline was run with the " << baselineEngine << " engine and " << baseline.getNumber("index_bits")
+			<< " bit indices, this run with the " << currentEngine << " engine and " << current.getNumber("index_bits") << " bit indices" << std::endl;
+		return -1;
+	}
+
+	BaselineCheck check(threshold);
+	const JsonValue &meshes = *current.get("meshes");
+	const JsonValue &baselineMeshes = *baseline.get("meshes");
+	for (size_t m = 0; m < meshes.items.size(); m++)
+	{
+		const JsonValue &mesh = meshes.items[m];
+		check.where = mesh.getString("name");
+		const JsonValue* before = findMesh(baselineMeshes, check.where);
+		if (before == NULL)
+		{
+			std::cout << check.where << " is not in the baseline" << std::endl;
+			continue;
+		}
+		//a mesh that can't be loaded anymore has no times to get slower, it fails on its own
+		if (mesh.getNumber("ok") == 0)
+		{
+			if (before->getNumber("ok") != 0)
+			{
+				check.regressions++;
+				std::cout << check.where << " loaded in the baseline and fails now  REGRESSION" << std::endl;
+			}
+			else std::cout << check.where << " fails in both runs" << std::endl;
+			continue;
+		}
+		if (before->getNumber("ok") == 0)
+		{
+			std::cout << check.where << " failed in the baseline, nothing to compare" << std::endl;
+			continue;
+		}
+		check.checkPhase("load", *before, mesh);
+		check.checkMemory("load_peak_rss_bytes", *before, mesh);
+
+		const JsonValue* ratios = mesh.get("ratios");
+		for (size_t i = 0; ratios != NULL && i < ratios->items.size(); i++)
+		{
+			const JsonValue &ratio = ratios->items[i];
+			char where[256];
+			snprintf(where, sizeof(where), "%s ratio %.2f", mesh.getString("name").c_str(), ratio.getNumber("ratio"));
+			check.where = where;
+			const JsonValue* beforeRatio = findRatio(*before, ratio.getNumber("ratio"));
+			if (beforeRatio == NULL)
+			{
+				std::cout << check.where << " is not in the baseline" << std::endl;
+				continue;
+			}
+			double trianglesBefore = beforeRatio->getNumber("triangles_out"), trianglesAfter = ratio.getNumber("triangles_out");
+			if (trianglesBefore != trianglesAfter)
+			{
+				check.regressions++;
+				check.report("triangles out", trianglesBefore, trianglesAfter, "CHANGED");
+				continue;
+			}
+			check.checkPhase("setup", *beforeRatio, ratio);
+			check.checkPhase("collapse", *beforeRatio, ratio);
+			check.checkMemory("peak_rss_bytes", *beforeRatio, ratio);
+		}
+	}
+
+	//what this run left out
+	for (size_t m = 0; m < baselineMeshes.items.size(); m++)
+	{
+		const JsonValue &before = baselineMeshes.items[m];
+		const JsonValue* mesh = findMesh(meshes, before.getString("name"));
+		if (mesh == NULL)
+		{
+			std::cout << before.getString("name") << " is only in the baseline" << std::endl;
+			continue;
+		}
+		const JsonValue* ratios = before.get("ratios");
+		for (size_t i = 0; mesh->getNumber("ok") != 0 && ratios != NULL && i < ratios->items.size(); i++)
+			if (findRatio(*mesh, ratios->items[i].getNumber("ratio")) == NULL)
+			{
+				char where[256];
+				snprintf(where, sizeof(where), "%s ratio %.2f", before.getString("name").c_str(), ratios->items[i].getNumber("ratio"));
+				std::cout << where << " is only in the baseline" << std::endl;
+			}
+	}
+
+	std::cout << check.compared << " measures against " << baselineFile << ", " << check.regressions << " regressed, "
+		<< check.improvements << " improved by more than " << threshold * 100 << "%" << std::endl;
+	return (int)check.regressions;
+}
@@ -0,0 +1,582 @@
+/*  Headless batch simplifier.
+	 + Takes input files or directories and simplifies every mesh found to the given targets, with the fast
+   contraction engine unless --reference asks for the reference one
+	 + The meshes are processed concurrently on a thread pool (-j N)
+	 + Prints a summary per file with the timings and the triangle counts
+	 + With -m every result is measured against its input, Hausdorff and RMS distance (see meshdistance.h)
+	 + "generate" writes a synthetic mesh instead (see meshgenerator.h)
+	 + "distance" measures two meshes against each other instead
+*/
+
+#include "meshdata.h"
+#include "threadpool.h"
+#include "objwriter.h"
+#include "glbwriter.h"
+#include "meshcodec.h"
+#include "vertexcache.h"
+#include "meshgenerator.h"
+#include "trace.h"
+#include "memorystats.h"
+#include "meshdistance.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#include <windows.h>
+#else
+	#include <dirent.h>
+#endif
+
+struct FileResult
+{
+	std::string path;
+	bool ok;
+	unsigned long long trianglesIn;
+	unsigned long long trianglesOut;
+	double loadMs;
+	double simplifyMs;
+	double saveMs;
+	size_t rawBytes;		//with -z, the live arrays
+	size_t compressedBytes;
+	double decodeMs;
+	unsigned long long optimizedTriangles;	//with -O, the ACMRs are weighted by the triangles of every level
+	double acmrBefore;
+	double acmrAfter;
+	double optimizeMs;
+	double hausdorff;	//with -m, the worst of the levels, in % of the bounding box diagonal of the input
+	double rms;
+	double measureMs;
+};
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+//encodes the mesh, times decoding it back and writes it
+static bool writeCompressed(const MeshData &mesh, const std::string &path, const MeshCodecOptions &options, FileResult &r)
+{
+	std::vector<unsigned char> data;
+	if (!encodeMesh(mesh, options, data))
+		return false;
+
+	MeshData decoded;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	if (!decodeMesh(&data[0], data.size(), decoded))
+		return false;
+	r.decodeMs += elapsedMs(start);
+	r.rawBytes += rawMeshSize(mesh);
+	r.compressedBytes += data.size();
+
+	FILE* f = fopen(path.c_str(), "wb");
+	if (f == NULL)
+		return false;
+	bool ok = fwrite(&data[0], 1, data.size(), f) == data.size();
+	return (fclose(f) == 0) && ok;
+}
+
+static bool isDirectory(const std::string &path)
+{
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0)
+		return false;
+	return (st.st_mode & S_IFDIR) != 0;
+}
+
+//creates path if it isn't there, its parent has to be
+static bool makeDirectory(const std::string &path)
+{
+	if (isDirectory(path))
+		return true;
+#ifdef _WIN32
+	return CreateDirectory(path.c_str(), NULL) != 0;
+#else
+	return mkdir(path.c_str(), 0755) == 0;
+#endif
+}
+
+static bool hasExtension(const std::string &path, const char* ext)
+{
+	size_t len = strlen(ext);
+	if (path.size() < len)
+		return false;
+	for (size_t i = 0; i < len; i++)
+		if (tolower(path[path.size() - len + i]) != ext[i])
+			return false;
+	return true;
+}
+
+static bool isMeshFile(const std::string &path)
+{
+	return hasExtension(path, ".obj") || hasExtension(path, ".ply") || hasExtension(path, ".stl") || hasExtension(path, ".ssmz");
+}
+
+//appends the meshes found directly inside a directory
+static void listMeshes(const std::string &dir, std::vector<std::string> &files)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATA data;
+	HANDLE h = FindFirstFile((dir + "\\*").c_str(), &data);
+	if (h == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		std::string name = data.cFileName;
+		if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && isMeshFile(name))
+			files.push_back(dir + "/" + name);
+	} while (FindNextFile(h, &data));
+	FindClose(h);
+#else
+	DIR* d = opendir(dir.c_str());
+	if (d == NULL)
+		return;
+	struct dirent* entry;
+	while ((entry = readdir(d)) != NULL)
+	{
+		std::string path = dir + "/" + entry->d_name;
+		if (!isDirectory(path) && isMeshFile(path))
+			files.push_back(path);
+	}
+	closedir(d);
+#endif
+}
+
+static std::string baseName(const std::string &path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+static std::string stemName(const std::string &path)
+{
+	std::string name = baseName(path);
+	size_t dot = name.find_last_of('.');
+	return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+//"1,0.5,0.25" -> {1, 0.5, 0.25}
+static std::vector<float> parseRatios(const char* text)
+{
+	std::vector<float> ratios;
+	while (*text)
+	{
+		char* end;
+		float r = (float)strtod(text, &end);
+		if (end == text)
+			break;
+		ratios.push_back(r);
+		text = *end == ',' ? end + 1 : end;
+	}
+	return ratios;
+}
+
+//reorders the mesh for the GPU and adds its cache misses before and after to the totals
+static void optimizeForGPU(MeshData &mesh, FileResult &r)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	float before = computeACMR(mesh);
+	optimizeVertexCache(mesh);
+	optimizeVertexFetch(mesh);
+	r.optimizeMs += elapsedMs(start);
+
+	//only the live triangles are left
+	unsigned long long triangles = mesh.triangles.size();
+	r.acmrBefore += before * triangles;
+	r.acmrAfter += computeACMR(mesh) * triangles;
+	r.optimizedTriangles += triangles;
+}
+
+//generate <shape> <triangles> <output> [--seed N]
+static int generateCommand(int argc, char **argv)
+{
+	unsigned int seed = 1;
+	std::vector<std::string> args;
+	for (int i = 0; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else args.push_back(argv[i]);
+	}
+
+	MeshShape shape;
+	if (args.size() != 3 || !parseMeshShape(args[0].c_str(), shape))
+	{
+		std::cout << "usage: simplify generate <sphere|terrain|torus|scan> <triangles> <output.ply|.stl|.ssmz|.obj> [--seed N]" << std::endl;
+		return 1;
+	}
+
+	MeshData mesh;
+	mesh.verbose = false;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	if (!generateMesh(shape, strtoull(args[1].c_str(), NULL, 10), seed, mesh))
+		return 1;
+	double generateMs = elapsedMs(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	if (!mesh.save(args[2].c_str()))
+		return 1;
+
+	char line[512];
+	snprintf(line, sizeof(line), "%-40s %s %9llu tris %9llu verts  generate %9.2f ms  save %9.2f ms", baseName(args[2]).c_str(),
+		meshShapeName(shape), (unsigned long long)mesh.triangles.size(), (unsigned long long)mesh.indexed_positions.size(), generateMs, elapsedMs(start));
+	std::cout << line << std::endl;
+	return 0;
+}
+
+//distance <a> <b> [--samples N] [--seed N]
+static int distanceCommand(int argc, char **argv)
+{
+	DistanceOptions options;
+	std::vector<std::string> args;
+	for (int i = 0; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+			options.samples = strtoull(argv[++i], NULL, 10);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			options.seed = (unsigned int)strtoul(argv[++i], NULL, 10);
+		else args.push_back(argv[i]);
+	}
+	if (args.size() != 2)
+	{
+		std::cout << "usage: simplify distance <a> <b> [--samples N] [--seed N]" << std::endl;
+		return 1;
+	}
+
+	MeshData a, b;
+	a.verbose = b.verbose = false;
+	if (!a.load(args[0].c_str()) || !b.load(args[1].c_str()))
+		return 1;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	MeshDistance distance;
+	if (!measureDistance(a, b, options, distance))
+	{
+		std::cerr << "Nothing to measure, a mesh has no triangles" << std::endl;
+		return 1;
+	}
+	double measureMs = elapsedMs(start);
+
+	//in % of the diagonal of a too, it's what LOD tolerances are usually given in
+	double scale = distance.diagonal > 0 ? 100 / distance.diagonal : 0;
+	const DistanceStats* sides[2] = { &distance.forward, &distance.backward };
+	const char* names[2] = { "a -> b", "b -> a" };
+	char line[512];
+	for (int s = 0; s < 2; s++)
+	{
+		snprintf(line, sizeof(line), "%s     hausdorff %12.6g (%8.4f%%)  rms %12.6g (%8.4f%%)  mean %12.6g  %9llu samples", names[s],
+			sides[s]->hausdorff, sides[s]->hausdorff * scale, sides[s]->rms, sides[s]->rms * scale, sides[s]->mean, sides[s]->samples);
+		std::cout << line << std::endl;
+	}
+	snprintf(line, sizeof(line), "symmetric  hausdorff %12.6g (%8.4f%%)  rms %12.6g (%8.4f%%)  diagonal %g  %.2f ms", distance.hausdorff,
+		distance.hausdorff * scale, distance.rms, distance.rms * scale, distance.diagonal, measureMs);
+	std::cout << line << std::endl;
+	return 0;
+}
+
+//adds the distance of a result to its input to the worst of the file
+static void measureResult(const MeshData &original, const MeshData &result, unsigned int threads, FileResult &r)
+{
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	DistanceOptions options;
+	options.threads = threads;
+	MeshDistance distance;
+	if (measureDistance(original, result, options, distance) && distance.diagonal > 0)
+	{
+		r.hausdorff = std::max(r.hausdorff, 100 * distance.hausdorff / distance.diagonal);
+		r.rms = std::max(r.rms, 100 * distance.rms / distance.diagonal);
+	}
+	r.measureMs += elapsedMs(start);
+}
+
+static void printUsage()
+{
+	std::cout << "usage: simplify [options] <file.obj|file.ply|file.stl|file.ssmz|directory>..." << std::endl
+		<< "  -t, --triangles N   triangles to keep" << std::endl
+		<< "  -r, --ratio R       fraction of the triangles to keep (0..1)" << std::endl
+		<< "  -e, --error E       stop when the cheapest contraction costs more than E, a sum of squared distances to triangle" << std::endl
+		<< "                      planes in mesh units. The engines sum different planes, the same E stops them at different points" << std::endl
+		<< "  --reference         use the reference contraction engine instead of the fast one (--fast, the default, see" << std::endl
+		<< "                      fastcontraction.h). It is O(n^2), about a minute for a mesh of 10000 triangles" << std::endl
+		<< "  -l, --lods R1,R2..  build a LOD chain at these ratios, written as name_lodN in the format read. With -t, -r" << std::endl
+		<< "                      or -e the chain starts from that result and the ratios are of its triangles" << std::endl
+		<< "  -o, --output DIR    write the simplified meshes to DIR, in the format they were read" << std::endl
+		<< "  -g, --glb           write name.glb instead, with every LOD level in it" << std::endl
+		<< "  --no-quantize       keep float attributes and uint32 indices in the GLB" << std::endl
+		<< "  -m, --measure       measure the Hausdorff and RMS distance of every result to its input" << std::endl
+		<< "  --max-distance PCT  fail the files with a result further than PCT % of the bounding box diagonal (implies -m)" << std::endl
+		<< "  -O, --optimize      reorder the triangles and vertices of the results for the GPU caches, reports the ACMR" << std::endl
+		<< "  -z, --compress      write name.ssmz instead and report the compression ratio and decode speed" << std::endl
+		<< "  --bits N            position bits of the compressed meshes (default 16)" << std::endl
+		<< "  -j N                meshes processed at the same time (default: one per core)" << std::endl
+		<< "  --memory            print the memory of every structure at the end of each phase" << std::endl
+		<< "  --trace FILE        write the phases and counters as Chrome trace events (needs SIMPLIFICATION_TRACE)" << std::endl
+		<< "   or: simplify generate <sphere|terrain|torus|scan> <triangles> <output> [--seed N]" << std::endl
+		<< "   or: simplify distance <a> <b> [--samples N] [--seed N]" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc > 1 && strcmp(argv[1], "generate") == 0)
+		return generateCommand(argc - 2, argv + 2);
+	if (argc > 1 && strcmp(argv[1], "distance") == 0)
+		return distanceCommand(argc - 2, argv + 2);
+
+	SimplifyOptions options;
+	options.engine = SIMPLIFY_FAST;
+	std::string outputDir;
+	unsigned int numThreads = 0;
+	std::vector<std::string> inputs;
+	std::vector<float> lodRatios;
+	bool glb = false, quantize = true, compress = false, optimize = false, memory = false, measure = false;
+	double maxDistance = 0;
+	MeshCodecOptions codecOptions;
+	std::string traceFile;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if ((arg == "-t" || arg == "--triangles") && hasValue)
+			options.target_triangles = (MeshIndex)strtoull(argv[++i], NULL, 10);
+		else if ((arg == "-r" || arg == "--ratio") && hasValue)
+			options.target_ratio = (float)atof(argv[++i]);
+		else if ((arg == "-e" || arg == "--error") && hasValue)
+			options.max_error = atof(argv[++i]);
+		else if (arg == "--fast")
+			options.engine = SIMPLIFY_FAST;
+		else if (arg == "--reference")
+			options.engine = SIMPLIFY_REFERENCE;
+		else if ((arg == "-l" || arg == "--lods") && hasValue)
+			lodRatios = parseRatios(argv[++i]);
+		else if ((arg == "-o" || arg == "--output") && hasValue)
+			outputDir = argv[++i];
+		else if (arg == "-g" || arg == "--glb")
+			glb = true;
+		else if (arg == "--no-quantize")
+			quantize = false;
+		else if (arg == "-m" || arg == "--measure")
+			measure = true;
+		else if (arg == "--max-distance" && hasValue)
+		{
+			maxDistance = atof(argv[++i]);
+			measure = true;
+		}
+		else if (arg == "-O" || arg == "--optimize")
+			optimize = true;
+		else if (arg == "-z" || arg == "--compress")
+			compress = true;
+		else if (arg == "--bits" && hasValue)
+			codecOptions.positionBits = (unsigned int)atoi(argv[++i]);
+		else if (arg == "--memory")
+			memory = true;
+		else if (arg == "--trace" && hasValue)
+			traceFile = argv[++i];
+		else if (arg == "-j" && hasValue)
+			numThreads = (unsigned int)atoi(argv[++i]);
+		else if (arg == "-h" || arg == "--help")
+		{
+			printUsage();
+			return 0;
+		}
+		else if (arg[0] == '-')
+		{
+			std::cerr << "Unknown option: " << arg << std::endl;
+			printUsage();
+			return 1;
+		}
+		else inputs.push_back(arg);
+	}
+
+	std::vector<std::string> files;
+	for (unsigned int i = 0; i < inputs.size(); i++)
+	{
+		if (isDirectory(inputs[i]))
+			listMeshes(inputs[i], files);
+		else files.push_back(inputs[i]);
+	}
+
+	if (files.empty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	//before any work, every file would fail to write at the end otherwise
+	if (!outputDir.empty() && !makeDirectory(outputDir))
+	{
+		std::cerr << "Can't create the output directory: " << outputDir << std::endl;
+		return 1;
+	}
+
+	if (!traceFile.empty() && !traceStart())
+	{
+		std::cerr << "Tracing is not compiled in, build with SIMPLIFICATION_TRACE defined" << std::endl;
+		return 1;
+	}
+
+	std::vector<FileResult> results(files.size());
+	std::mutex printMutex;
+	std::chrono::high_resolution_clock::time_point batchStart = std::chrono::high_resolution_clock::now();
+
+	{
+		ThreadPool pool(numThreads);
+		for (unsigned int i = 0; i < files.size(); i++)
+		{
+			pool.enqueue([&, i]() {
+				FileResult &r = results[i];
+				r.path = files[i];
+				r.ok = false;
+				r.trianglesIn = r.trianglesOut = 0;
+				r.loadMs = r.simplifyMs = r.saveMs = 0;
+				r.rawBytes = r.compressedBytes = 0;
+				r.decodeMs = 0;
+				r.optimizedTriangles = 0;
+				r.acmrBefore = r.acmrAfter = r.optimizeMs = 0;
+				r.hausdorff = r.rms = r.measureMs = 0;
+
+				MeshData mesh;
+				MemoryTracker tracker;
+				mesh.verbose = false;
+				if (memory)
+					mesh.memory = &tracker;
+				//files already run in parallel, only split the parsing and measuring of a lone file
+				unsigned int threads = files.size() > 1 ? 1 : numThreads;
+				mesh.loadThreads = threads;
+
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				if (mesh.load(files[i].c_str()))
+				{
+					r.loadMs = elapsedMs(start);
+					r.trianglesIn = mesh.totalTriangles();
+					MeshData original;
+					if (measure)
+						mesh.copyGeometry(original);
+
+					if (lodRatios.empty())
+					{
+						start = std::chrono::high_resolution_clock::now();
+						r.trianglesOut = mesh.simplify(options);
+						r.simplifyMs = elapsedMs(start);
+						if (measure)
+							measureResult(original, mesh, threads, r);
+						if (optimize)
+							optimizeForGPU(mesh, r);
+
+						r.ok = true;
+						if (!outputDir.empty())
+						{
+							start = std::chrono::high_resolution_clock::now();
+							if (compress)
+								r.ok = writeCompressed(mesh, outputDir + "/" + stemName(files[i]) + ".ssmz", codecOptions, r);
+							else if (glb)
+								r.ok = writeGLB((outputDir + "/" + stemName(files[i]) + ".glb").c_str(), std::vector<const MeshData*>(1, &mesh), quantize);
+							else r.ok = mesh.save((outputDir + "/" + baseName(files[i])).c_str());
+							r.saveMs = elapsedMs(start);
+						}
+					}
+					else
+					{
+						std::vector<MeshData> lods;
+						start = std::chrono::high_resolution_clock::now();
+						mesh.simplify(options);
+						mesh.buildLODs(lodRatios, lods, options.engine);
+						r.simplifyMs = elapsedMs(start);
+						r.trianglesOut = lods.back().totalTriangles();
+						for (unsigned int l = 0; l < lods.size() && measure; l++)
+							measureResult(original, lods[l], threads, r);
+						if (optimize)
+						{
+							for (unsigned int l = 0; l < lods.size(); l++)
+								optimizeForGPU(lods[l], r);
+						}
+
+						r.ok = true;
+						if (!outputDir.empty())
+						{
+							std::vector<const MeshData*> levels;
+							std::vector<std::string> names;
+							std::string extension = baseName(files[i]).substr(stemName(files[i]).size());
+							for (unsigned int l = 0; l < lods.size(); l++)
+							{
+								levels.push_back(&lods[l]);
+								names.push_back(outputDir + "/" + stemName(files[i]) + "_lod" + std::to_string(l) + extension);
+							}
+							start = std::chrono::high_resolution_clock::now();
+							if (compress)
+							{
+								for (unsigned int l = 0; l < lods.size() && r.ok; l++)
+									r.ok = writeCompressed(lods[l], outputDir + "/" + stemName(files[i]) + "_lod" + std::to_string(l) + ".ssmz", codecOptions, r);
+							}
+							else if (glb)
+								r.ok = writeGLB((outputDir + "/" + stemName(files[i]) + ".glb").c_str(), levels, quantize);
+							else if (hasExtension(extension, ".obj"))
+								r.ok = writeOBJs(levels, names, (unsigned int)levels.size());
+							else
+							{
+								for (unsigned int l = 0; l < lods.size() && r.ok; l++)
+									r.ok = lods[l].save(names[l].c_str());
+							}
+							r.saveMs = elapsedMs(start);
+						}
+					}
+				}
+
+				//the results are still written, to look at what went wrong
+				if (maxDistance > 0 && r.hausdorff > maxDistance)
+					r.ok = false;
+
+				std::lock_guard<std::mutex> lock(printMutex);
+				char line[512];
+				snprintf(line, sizeof(line), "%-40s %s %9llu -> %9llu tris  load %9.2f ms  simplify %9.2f ms  save %9.2f ms",
+					baseName(r.path).c_str(), r.ok ? "ok  " : "FAIL", r.trianglesIn, r.trianglesOut, r.loadMs, r.simplifyMs, r.saveMs);
+				std::cout << line;
+				if (r.optimizedTriangles)
+				{
+					snprintf(line, sizeof(line), "  acmr %4.2f -> %4.2f (%.2f ms)", r.acmrBefore / r.optimizedTriangles,
+						r.acmrAfter / r.optimizedTriangles, r.optimizeMs);
+					std::cout << line;
+				}
+				if (measure && r.trianglesIn)
+				{
+					snprintf(line, sizeof(line), "  hausdorff %7.4f%%  rms %7.4f%% (%.2f ms)", r.hausdorff, r.rms, r.measureMs);
+					std::cout << line;
+				}
+				if (r.compressedBytes)
+				{
+					snprintf(line, sizeof(line), "  ratio %6.2fx  decode %8.1f MB/s", (double)r.rawBytes / r.compressedBytes,
+						r.rawBytes / (1024.0 * 1024.0) / (r.decodeMs / 1000.0));
+					std::cout << line;
+				}
+				std::cout << std::endl;
+				if (memory)
+					tracker.print(std::cout, "    ");
+			});
+		}
+		pool.wait();
+	}
+
+	unsigned int failed = 0;
+	unsigned long long totalIn = 0, totalOut = 0;
+	for (unsigned int i = 0; i < results.size(); i++)
+	{
+		if (!results[i].ok)
+			failed++;
+		totalIn += results[i].trianglesIn;
+		totalOut += results[i].trianglesOut;
+	}
+
+	bool traced = traceFile.empty() || traceWrite(traceFile.c_str());
+
+	std::cout << files.size() << " files, " << failed << " failed, " << totalIn << " -> " << totalOut
+		<< " triangles in " << elapsedMs(batchStart) << " ms" << std::endl;
+
+	return failed || !traced ? 1 : 0;
+}
@@ -0,0 +1,60 @@
+/*  Output file that collects what is written in a big block and hands it to the OS in one go.
+	The writers format straight into the block: reserve room, write, then commit the end.
+*/
+
+#ifndef BUFFEREDFILE_H
+#define BUFFEREDFILE_H
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define BUFFEREDFILE_SIZE (4 << 20)
+
+class BufferedFile
+{
+public:
+	BufferedFile(FILE* f) : file(f), buffer(BUFFEREDFILE_SIZE), used(0), failed(false) {}
+
+	//room for at least bytes more (never more than BUFFEREDFILE_SIZE), flushing first if the buffer is almost full
+	char* reserve(size_t bytes)
+	{
+		if (used + bytes > buffer.size())
+			flush();
+		return &buffer[used];
+	}
+	void commit(char* end) { used = end - &buffer[0]; }
+
+	void write(const void* data, size_t bytes)
+	{
+		if (used + bytes > buffer.size())
+		{
+			flush();
+			if (bytes > buffer.size())
+			{
+				if (fwrite(data, 1, bytes, file) != bytes)
+					failed = true;
+				return;
+			}
+		}
+		memcpy(&buffer[used], data, bytes);
+		used += bytes;
+	}
+
+	bool flush()
+	{
+		if (used && fwrite(&buffer[0], 1, used, file) != used)
+			failed = true;
+		used = 0;
+		return !failed;
+	}
+	bool ok() const { return !failed; }
+
+private:
+	FILE* file;
+	std::vector<char> buffer;
+	size_t used;
+	bool failed;
+};
+
+#endif
@@ -0,0 +1,90 @@
+/*  Bounding volume hierarchy over the live triangles of a mesh, for the spatial queries: closest point (error
+	measurement, projecting vertices back on a surface), rays (picking) and boxes.
+	 + Built top down, every split is the best of the surface area heuristic over bins of the triangle centers.
+	   Big meshes split their top levels first and build the subtrees below on a thread pool
+	 + The nodes are flattened depth first: the first child follows its parent, the parent keeps where the second is
+	 + The corners of the triangles are copied in the order of the leaves, the mesh can change or go away afterwards
+	 + refit follows the vertices of the same triangles when they move, without building again
+	 + The batch queries sort their queries along a Morton curve so the ones close in space run one after the other
+	   and find the nodes they share still in cache, and split them over a thread pool
+*/
+
+#ifndef BVH_H
+#define BVH_H
+
+#include "framework.h"
+
+class MeshData;
+
+#define BVH_LEAF_TRIANGLES 4			//at most in a leaf
+#define BVH_BINS 16						//split candidates along the widest axis of the centers
+#define BVH_MAX_DEPTH 48				//past this the splits are at the median, it bounds the query stack
+#define BVH_PARALLEL_TRIANGLES 32768	//subtrees up to this size are built by one thread
+
+struct BVHClosestHit
+{
+	DVector3 point;
+	double distance; //squared
+	MeshIndex triangle;
+	bool found;
+};
+
+struct BVHRayHit
+{
+	double t;			//origin + direction * t, in lengths of direction
+	double u, v;		//barycentric coordinates of the hit, on the edges from the first corner to the second and third
+	MeshIndex triangle;
+	bool found;
+};
+
+class TriangleBVH
+{
+public:
+	struct Node
+	{
+		Vector3 min;
+		Vector3 max;
+		MeshIndex offset;	//first triangle of a leaf, second child of the rest
+		MeshIndex count;	//triangles of a leaf, 0 for the rest
+	};
+
+	TriangleBVH();
+	//threads 0: one per core, 1 builds on the calling thread
+	void build(const MeshData &mesh, unsigned int threads = 1);
+	//after the vertices of the triangles it was built with moved. false if any of them isn't in mesh anymore,
+	//then nothing changed and it still answers for the old positions. The tree gets looser the further they
+	//go, build again after big changes
+	bool refit(const MeshData &mesh);
+
+	bool empty() const { return this->nodes.empty(); }
+	MeshIndex numTriangles() const { return (MeshIndex)this->triangles.size(); }
+	const Node& root() const { return this->nodes[0]; }
+	const std::vector<Node>& getNodes() const { return this->nodes; }
+	size_t memoryBytes() const;
+
+	//closest point of the triangles to p and the index in mesh.triangles of the one it is on.
+	//false when there are no triangles
+	bool closest(const DVector3 &p, DVector3 &point, MeshIndex &triangle) const;
+	//the first triangle along the ray from origin, up to maxT. Both sides of the triangles are hit
+	bool intersectRay(const DVector3 &origin, const DVector3 &direction, double maxT, BVHRayHit &hit) const;
+	//appends the triangles that touch the box
+	void overlapBox(const Vector3 &min, const Vector3 &max, std::vector<MeshIndex> &triangles) const;
+
+	//one hit per query, in the order of the queries. threads 0: one per core
+	void closestBatch(const std::vector<DVector3> &points, std::vector<BVHClosestHit> &hits, unsigned int threads = 0) const;
+	void intersectRays(const std::vector<DVector3> &origins, const std::vector<DVector3> &directions, double maxT,
+		std::vector<BVHRayHit> &hits, unsigned int threads = 0) const;
+
+private:
+	std::vector<Node> nodes;
+	std::vector<Vector3> corners;		//3 per triangle, in the order of the leaves
+	std::vector<MeshIndex> triangles;	//in mesh.triangles, in the same order
+
+	//the order of the queries along a Morton curve over the bounds of the tree
+	void mortonOrder(const std::vector<DVector3> &points, std::vector<size_t> &order) const;
+};
+
+//closest point to p on the triangle abc
+DVector3 closestOnTriangle(const DVector3 &p, const DVector3 &a, const DVector3 &b, const DVector3 &c);
+
+#endif
@@ -0,0 +1,24 @@
+/*  The fast engine of MeshData::simplify, the same quadric error contraction as edgeContraction in about
+	O(n log n) instead of O(n^2).
+	 + Every vertex keeps the sum of the quadrics of its triangles (double precision), a contraction adds them.
+	   The cost is the error against the current triangles plus a fraction of the error against the loaded ones
+	 + The candidates are in a binary heap, an entry is skipped when popped if one of its vertices changed
+	 + Contractions that flip a triangle or would join two sheets of the surface are rejected, and the borders
+	   get a perpendicular plane so open meshes keep their outline
+	 + The result is left as edgeContraction leaves it: the removed vertices and triangles are erased and the
+	   rest keep their order
+	edgeContraction stays as the reference, Simplification-Bench --compare checks this one against it.
+*/
+
+#ifndef FASTCONTRACTION_H
+#define FASTCONTRACTION_H
+
+#include "framework.h"
+
+class MeshData;
+
+//contracts until targetTriangles are left or the cheapest contraction costs more than maxError, returns the
+//triangles left. Only reads the positions and the triangles, the contraction topology is dropped
+MeshIndex fastEdgeContraction(MeshData &mesh, MeshIndex targetTriangles, double maxError);
+
+#endif
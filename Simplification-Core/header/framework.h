@@ -7,6 +7,8 @@
 
 #include <vector>
 #include <cmath>
+#include <cstdlib> //rand
+#include "meshindex.h"
 
 #ifndef PI
 #define PI 3.14159265359
@@ -90,6 +92,24 @@ public:
 	float dot( const Vector3& v ) const;
 };
 
+//double precision, for the sums of the simplification and the error measures
+class DVector3
+{
+public:
+	double x, y, z;
+
+	DVector3() { x = y = z = 0; }
+	DVector3(double x, double y, double z) { this->x = x; this->y = y; this->z = z; }
+	explicit DVector3(const Vector3& v) { x = v.x; y = v.y; z = v.z; }
+
+	DVector3 operator + (const DVector3& v) const { return DVector3(x + v.x, y + v.y, z + v.z); }
+	DVector3 operator - (const DVector3& v) const { return DVector3(x - v.x, y - v.y, z - v.z); }
+	DVector3 operator * (double s) const { return DVector3(x * s, y * s, z * s); }
+	double dot(const DVector3& v) const { return x * v.x + y * v.y + z * v.z; }
+	DVector3 cross(const DVector3& v) const { return DVector3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
+	Vector3 toFloat() const { return Vector3((float)x, (float)y, (float)z); }
+};
+
 
 class Vector4
 {
@@ -250,33 +270,39 @@ inline Vector3u operator * (float v, const Vector3u& c) { return Vector3u((unsig
 float ComputeSignedAngle( Vector2 a, Vector2 b);
 Vector3 RayPlaneCollision( const Vector3& plane_pos, const Vector3& plane_normal, const Vector3& ray_origin, const Vector3& ray_dir );
 
-class Edge
+//a and b are vertex indices, triangleIndex the triangle the edge was taken from
+template <typename Index>
+class BasicEdge
 {
 public:
-	Edge();
-	Edge(const unsigned &a, const unsigned &b);
-	bool operator==(const Edge& p);
-	bool contains(const unsigned int &value) const;
-	unsigned int a;
-	unsigned int b;
+	BasicEdge() { a = (Index)-1; b = (Index)-1; triangleIndex = 0; cost = 0; }
+	BasicEdge(const Index &a, const Index &b) { this->a = a; this->b = b; triangleIndex = 0; cost = 0; }
+	bool operator==(const BasicEdge& p) const { return (a == p.a && b == p.b) || (a == p.b && b == p.a); }
+	bool contains(const Index &value) const { return a == value || b == value; }
+	Index a;
+	Index b;
 	Matrix44 Q;
 	Vector3 w;
 	double cost;
 
-	unsigned int triangleIndex;
+	Index triangleIndex;
 };
 
-class Triangle
+template <typename Index>
+class BasicTriangle
 {
 public:
-	Triangle(unsigned int i, unsigned int j, unsigned int k);
+	BasicTriangle(Index i, Index j, Index k) { this->i = i; this->j = j; this->k = k; }
 
-	unsigned int i, j, k;
+	Index i, j, k;
 
-	bool containsIndex(unsigned int a);
-	bool containsIndices(unsigned int a, unsigned int b);
+	bool containsIndex(Index a) const { return i == a || j == a || k == a; }
+	bool containsIndices(Index a, Index b) const { return this->containsIndex(a) && this->containsIndex(b); }
 };
 
+typedef BasicEdge<MeshIndex> Edge;
+typedef BasicTriangle<MeshIndex> Triangle;
+
 Vector4 multV4xM4(const Vector4 &v, const Matrix44 &m);
 Vector4 multM4xV4(const Matrix44 &m, const Vector4 &v);
 
@@ -0,0 +1,20 @@
+/*  glTF 2.0 binary (GLB) writer for LOD chains. Every level becomes a mesh with a single primitive and a
+	node named LODn; the scene shows LOD0 and lists the nodes of all the levels in its extras. All the data
+	goes in one BIN chunk, levels with the same vertices share their attribute accessors.
+
+	With quantization (KHR_mesh_quantization) positions are uint16 on a grid shared by all the levels,
+	undone by the node matrix, normals are normalized int8 and uvs normalized uint16 when they are in [0, 1].
+	Indices are uint16 whenever the level has few enough vertices.
+*/
+
+#ifndef GLBWRITER_H
+#define GLBWRITER_H
+
+#include <vector>
+
+class MeshData;
+
+//levels in order, LOD0 first. Only the live triangles and the vertices they use are written
+bool writeGLB(const char* filename, const std::vector<const MeshData*> &levels, bool quantize = true);
+
+#endif
@@ -0,0 +1,38 @@
+/*  Picks the level of a LOD chain to draw from the size of the mesh on screen. Level i keeps ratios[i] of the
+	triangles, so it looks as dense as the full mesh at fullDetailPixels while its size stays below
+	fullDetailPixels * sqrt(ratios[i]). A level only changes once the size goes past that threshold by the
+	hysteresis fraction, so a mesh sitting on a threshold doesn't flicker between two levels.
+*/
+
+#ifndef LODSELECTOR_H
+#define LODSELECTOR_H
+
+#include <vector>
+#include "framework.h"
+
+class MeshData;
+
+class LodSelector
+{
+public:
+	LodSelector();
+
+	void setLevels(const std::vector<float> &ratios); //descending, ratios[0] is the full mesh. Goes back to level 0
+	unsigned int select(float screenPixels); //the level for this frame, remembered for the next one
+	unsigned int getLevel() const { return level; }
+
+	float fullDetailPixels; //size on screen that needs the full mesh
+	float hysteresis;		//fraction past a threshold before changing level, 0.1 by default
+
+private:
+	std::vector<float> thresholds; //screen size below which each level is enough
+	unsigned int level;
+};
+
+//sphere around the vertices used by the live triangles
+void boundingSphere(const MeshData &mesh, Vector3 &center, float &radius);
+
+//diameter in pixels of a sphere seen by a perspective camera with a vertical fov
+float projectedSize(const Vector3 &center, float radius, const Vector3 &eye, float fovDegrees, float viewportHeight);
+
+#endif
@@ -0,0 +1,38 @@
+/*  Read only view of a whole file mapped in memory. The parsers scan it in place instead of copying it.
+*/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool open(const char* filename);
+	void close();
+
+	const char* data() const { return (const char*)view; }
+	const char* end() const { return (const char*)view + length; }
+	size_t size() const { return length; }
+	bool isOpen() const { return opened; }
+
+private:
+	void* view;
+	size_t length;
+	bool opened;
+#ifdef _WIN32
+	void* file;
+	void* mapping;
+#else
+	int fd;
+#endif
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+};
+
+#endif
@@ -0,0 +1,32 @@
+/*  The Matrix44 and Vector4 kernels the simplification spends its time in, in scalar, SSE and AVX versions.
+	The best set the CPU supports is picked once at startup and Matrix44 goes through it.
+	All the versions do the same float operations in the same order as the scalar loops, so they give the
+	same bits, which keeps the costs and the contraction order the same on every machine.
+	Matrices are the 16 floats of Matrix44::m, row major.
+*/
+
+#ifndef MATHKERNELS_H
+#define MATHKERNELS_H
+
+struct MathKernels
+{
+	const char* name;
+	void (*multiply)(const float* a, const float* b, float* out);	//out = a * b, out can't be a or b
+	void (*add)(const float* a, const float* b, float* out);
+	void (*multM4xV4)(const float* m, const float* v, float* out);	//out = m * v, out can't be v
+	void (*multV4xM4)(const float* v, const float* m, float* out);	//out = v * m, out can't be v
+	bool (*inverse)(const float* m, float* out);					//Gauss-Jordan, out untouched if singular, can be m
+};
+
+extern const MathKernels* g_mathKernels; //the one in use, never NULL
+
+const MathKernels& scalarMathKernels();
+//NULL when the CPU or the build doesn't have them
+const MathKernels* sseMathKernels();
+const MathKernels* avxMathKernels();
+
+//the best of the above, what g_mathKernels starts as
+const MathKernels& bestMathKernels();
+void setMathKernels(const MathKernels &kernels);
+
+#endif
@@ -0,0 +1,78 @@
+/*  Memory accounting of the structures of a MeshData, to know what grows during loading and contraction.
+	The bytes are counted from the containers (capacity of the vectors, nodes of the maps and what their vectors
+	hold), not from the allocator, so they leave out the allocator overhead and the temporaries of the passes.
+	Give a MeshData a MemoryTracker and it samples itself while it parses and contracts, and closes a phase
+	at the end of parsing ("parse") or generateMesh ("generate"), buildTopology ("setup") and edgeContraction
+	("collapse").
+*/
+
+#ifndef MEMORYSTATS_H
+#define MEMORYSTATS_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+class MeshData;
+
+enum MemoryStructure
+{
+	MEMORY_EDGES,
+	MEMORY_VERTEX_TRIANGLES,
+	MEMORY_VERTEX_EDGES,
+	MEMORY_TRIANGLES,
+	MEMORY_POSITIONS,
+	MEMORY_NORMALS,
+	MEMORY_UVS,
+	MEMORY_ADJACENCY,
+	MEMORY_QUADRICS,
+	MEMORY_PARSE_BUFFERS,	//only while loading, filled by the loaders
+	MEMORY_STRUCTURES
+};
+
+//"edges", "vertex_triangles"...
+const char* memoryStructureName(int structure);
+
+template<class T> size_t vectorBytes(const std::vector<T> &v) { return v.capacity() * sizeof(T); }
+
+struct MemoryUsage
+{
+	size_t bytes[MEMORY_STRUCTURES];
+
+	MemoryUsage();
+	size_t total() const;
+	void max(const MemoryUsage &other); //per structure
+};
+
+//everything but the parse buffers
+void measureMemory(const MeshData &mesh, MemoryUsage &usage);
+
+class MemoryTracker
+{
+public:
+	struct Phase
+	{
+		std::string name;
+		MemoryUsage live;	//at the end of the phase
+		MemoryUsage peak;	//of every structure during the phase
+		size_t peakTotal;	//of all of them at the same time
+	};
+
+	MemoryTracker();
+	void sample(const MemoryUsage &usage);
+	void sample(const MeshData &mesh);
+	void endPhase(const char* name, const MeshData &mesh);
+	void clear();
+
+	const std::vector<Phase>& getPhases() const { return phases; }
+	//a line per phase and one per structure in use, in MB
+	void print(std::ostream &out, const char* indent = "  ") const;
+
+private:
+	std::vector<Phase> phases;
+	MemoryUsage peak;
+	size_t peakTotal;
+};
+
+#endif
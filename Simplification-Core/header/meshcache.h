@@ -0,0 +1,75 @@
+/*  Binary mesh cache. A versioned container with the arrays of a MeshData stored as they are in memory,
+	so loading it is mapping the file and copying every section in one go, without any parsing.
+	Every section starts aligned to MESHCACHE_ALIGNMENT bytes. The values are stored little endian.
+
+	The header records the size, modification time and hash of the file the cache was made from,
+	a cache is only used while those still match.
+*/
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <stdint.h>
+#include <cstddef>
+
+class MeshData;
+
+#define MESHCACHE_MAGIC "SSMC"
+#define MESHCACHE_VERSION 1
+#define MESHCACHE_ALIGNMENT 64
+#define MESHCACHE_MAX_SECTIONS 16
+
+//optional sections
+#define MESHCACHE_ADJACENCY 1
+#define MESHCACHE_QUADRICS 2
+
+enum MeshCacheSectionType
+{
+	SECTION_POSITIONS = 1,		//Vector3 per vertex
+	SECTION_NORMALS,			//Vector3 per vertex
+	SECTION_UVS,				//Vector2, as read from the source
+	SECTION_TRIANGLES,			//Triangle (3 MeshIndex)
+	SECTION_ADJACENCY_OFFSETS,	//MeshIndex per vertex + 1
+	SECTION_ADJACENCY_TRIANGLES,//MeshIndex per triangle corner
+	SECTION_QUADRICS,			//Matrix44 per vertex
+	SECTION_VERTEX_UVS			//Vector2 per vertex
+};
+
+struct MeshCacheSource
+{
+	uint64_t size;
+	int64_t mtime;
+	uint64_t hash;
+};
+
+struct MeshCacheSection
+{
+	uint32_t type;
+	uint32_t elementSize;
+	uint64_t count;
+	uint64_t offset; //from the start of the file
+};
+
+struct MeshCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	MeshCacheSource source;
+	uint32_t numSections;
+	uint32_t reserved;
+	MeshCacheSection sections[MESHCACHE_MAX_SECTIONS];
+};
+
+//fills the size and modification time of a file, and its hash when asked (it has to read the whole file)
+bool getMeshCacheSource(const char* filename, MeshCacheSource &source, bool computeHash);
+uint64_t hashBytes(const void* data, size_t size);
+
+//writes the arrays of mesh plus the optional sections in flags (MESHCACHE_ADJACENCY, MESHCACHE_QUADRICS),
+//computing them if the mesh doesn't have them yet
+bool saveMeshCache(const char* filename, MeshData &mesh, const char* sourceFilename, unsigned int flags);
+
+//replaces the arrays of mesh with the ones in the cache. When sourceFilename is given the cache is rejected
+//unless it was made from that file: same size and time, or same content if only the time changed
+bool loadMeshCache(const char* filename, MeshData &mesh, const char* sourceFilename = NULL);
+
+#endif
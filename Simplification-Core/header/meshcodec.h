@@ -0,0 +1,40 @@
+/*  Compressed mesh container, for archiving meshes rather than loading them fast (see meshcache.h for that).
+	 + Positions are quantized to positionBits per axis inside the bounding box, normals are octahedral
+	   with normalBits per component and uvs are quantized to uvBits inside their bounding box
+	 + Vertices are sorted along a Morton curve and the triangles by their vertices, so consecutive
+	   elements are close and are stored as zigzag varint deltas of the previous one
+	 + Only the live triangles and the vertices they use are stored
+*/
+
+#ifndef MESHCODEC_H
+#define MESHCODEC_H
+
+#include <vector>
+#include <stdint.h>
+#include <cstddef>
+
+class MeshData;
+
+#define MESHCODEC_MAGIC "SSMZ"
+#define MESHCODEC_VERSION 1
+
+struct MeshCodecOptions
+{
+	unsigned int positionBits;	//1..24
+	unsigned int normalBits;	//1..16
+	unsigned int uvBits;		//1..24
+
+	MeshCodecOptions() { positionBits = 16; normalBits = 12; uvBits = 14; }
+};
+
+bool encodeMesh(const MeshData &mesh, const MeshCodecOptions &options, std::vector<unsigned char> &out);
+//replaces the arrays of mesh, false if the data is not a valid container
+bool decodeMesh(const unsigned char* data, size_t size, MeshData &mesh);
+
+//bytes the live part of the mesh takes as plain arrays (float attributes and 32 bit indices)
+size_t rawMeshSize(const MeshData &mesh);
+
+bool saveCompressedMesh(const char* filename, const MeshData &mesh, const MeshCodecOptions &options = MeshCodecOptions());
+bool loadCompressedMesh(const char* filename, MeshData &mesh);
+
+#endif
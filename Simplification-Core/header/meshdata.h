@@ -0,0 +1,137 @@
+/*  The MeshData contains the geometry and topology of a mesh, how to parse it from a file and how to simplify it
+	using edge contractions driven by quadric error metrics. It does not depend on OpenGL, SDL or GLUT.
+*/
+
+#ifndef MESHDATA_H
+#define MESHDATA_H
+
+#include <vector>
+#include <map>
+#include <cfloat>
+#include <functional>
+#include "framework.h"
+
+using namespace std;
+
+struct customVec3Comparator {
+	bool operator()(const Vector3& a, const Vector3& b) const
+	{
+		if (a.x != b.x)
+			return (a.x < b.x);
+
+		if (a.y != b.y)
+			return (a.y < b.y);
+
+		return (a.z < b.z);
+	}
+};
+
+struct LessCost
+{
+	bool operator()(const Edge& a, const Edge& b) const
+	{
+		return a.cost < b.cost;
+	}
+};
+
+enum SimplifyEngine
+{
+	SIMPLIFY_REFERENCE,	//edgeContraction, O(n^2), the one the others are checked against
+	SIMPLIFY_FAST		//fastEdgeContraction, see fastcontraction.h
+};
+
+//what to stop the simplification at, the first target reached wins
+struct SimplifyOptions
+{
+	MeshIndex target_triangles;		//triangles to keep (0 to ignore)
+	float target_ratio;				//fraction of the triangles to keep (0 to ignore)
+	double max_error;				//stop when the cheapest contraction costs more than this
+	SimplifyEngine engine;
+
+	SimplifyOptions() { target_triangles = 0; target_ratio = 0; max_error = DBL_MAX; engine = SIMPLIFY_REFERENCE; }
+};
+
+class MemoryTracker;
+
+class MeshData
+{
+public:
+	std::map<Vector3, vector<MeshIndex>, customVec3Comparator> vertexTriangles;
+	std::map<Vector3, vector<MeshIndex>, customVec3Comparator> vertexEdges;
+	vector<Edge> edges;
+
+	std::vector<Vector3> indexed_positions;
+	std::vector<Vector3> indexed_normals;
+	std::vector<Vector3> indexed_normalsFinal;
+	std::vector<Vector2> indexed_uvs;
+	std::vector<Vector2> indexed_uvsFinal;
+	std::vector<Triangle> triangles;
+
+	//precomputed from the loaded mesh (or read from a mesh cache), dropped once the mesh is contracted.
+	//The triangles of vertex v are adjacencyTriangles[adjacencyOffsets[v] .. adjacencyOffsets[v + 1])
+	std::vector<MeshIndex> adjacencyOffsets;
+	std::vector<MeshIndex> adjacencyTriangles;
+	std::vector<Matrix44> vertexQuadrics; //sum of the quadrics of the triangles around each position
+
+	bool verbose; //print the progress of loading and contraction
+	unsigned int loadThreads; //threads used to parse big files (0: one per core)
+	std::function<void(float)> progress; //if set, called during the contraction with the fraction done
+	MemoryTracker* memory; //if set, sampled while loading and contracting (see memorystats.h)
+	MeshIndex collapses; //contractions made by the last edgeContraction or simplify, either engine
+
+	//what changed since the renderer last uploaded the mesh, it sends those arrays again whole. Vertices
+	//cover every per vertex array, triangles the index array
+	bool dirtyVertices;
+	bool dirtyTriangles;
+
+	MeshData();
+	virtual ~MeshData() {}
+	void clear();
+	void dropPrecomputed();
+	void dropTopology(); //the vertex maps, the edges and the precomputed data, for passes that renumber the mesh
+	void swap(MeshData &other); //exchanges the geometry and topology, not the settings
+
+	Matrix44 getTriangleMatrix(const MeshIndex &tri);
+	Matrix44 getTriangleVectorMatrix(const std::vector<MeshIndex> &triangles);
+
+	void buildTopology();
+	void computeAdjacency();
+	void computeVertexQuadrics();
+	void addEdge(const MeshIndex &i, const MeshIndex &j, const MeshIndex &triangleIndex);
+	void insertEdge(const Edge &e);
+	void updateEdges(const MeshIndex &i);
+	MeshIndex totalTriangles();
+
+	void computeAllCosts();
+	void computeCost(Edge *edge);
+	void computeCost(Edge *edge, const Matrix44 &Q);
+	void edgeContraction(const MeshIndex &numTriang, const double &maxError = DBL_MAX);
+	//with the reference engine the topology is built first if a fast contraction dropped it
+	MeshIndex simplify(const SimplifyOptions &options);
+
+	//true for triangles with three different vertices in range, the contraction leaves degenerate ones behind
+	bool isLiveTriangle(const Triangle &t) const;
+	//numbers the vertices used by live triangles in order: remap[v] is the new index + 1, or 0 when unused.
+	//Returns how many vertices are used
+	MeshIndex remapUsedVertices(std::vector<MeshIndex> &remap) const;
+
+	//copies the arrays needed to render or save the mesh, not the topology
+	void copyGeometry(MeshData &out) const;
+	//simplifies this mesh in steps, storing a copy of the geometry at each ratio (descending, of the original triangles)
+	void buildLODs(const vector<float> &ratios, vector<MeshData> &lods, SimplifyEngine engine = SIMPLIFY_REFERENCE);
+
+	bool load(const char* filename); //by extension, .ply, .stl, .ssmz (see meshcodec.h) or .obj
+	bool loadCached(const char* filename); //uses filename.cache when it is up to date, writes it otherwise
+	bool save(const char* filename) const; //by extension, .ply (binary), .stl (binary), .ssmz or .obj
+
+	bool loadOBJ(const char* filename);
+	bool saveOBJ(const char* filename) const;
+	bool loadPLY(const char* filename);
+	bool savePLY(const char* filename, bool binary = true) const;
+	bool loadSTL(const char* filename);
+	bool saveSTL(const char* filename) const;
+	bool loadCompressed(const char* filename);
+	bool saveCompressed(const char* filename) const;
+};
+
+#endif
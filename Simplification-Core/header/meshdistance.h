@@ -0,0 +1,52 @@
+/*  Geometric error between two meshes, like between a LOD and the mesh it came from.
+	 + Points are sampled on the live triangles of one mesh and their closest points found on the other (see bvh.h)
+	 + The samples are the used vertices and points spread over the surface by area, the same ones for a seed
+	   whatever the threads
+	 + Hausdorff is the largest distance of all the samples, a lower bound of the exact one that tightens with more
+	   of them. RMS and the mean are over the area samples alone, so they are the average over the surface and
+	   don't lean to where the vertices are dense
+	 + Symmetric measures are the larger of both directions
+	 + The closest points are found with the batch queries of the BVH, on a thread pool
+*/
+
+#ifndef MESHDISTANCE_H
+#define MESHDISTANCE_H
+
+#include "framework.h"
+
+class MeshData;
+class TriangleBVH;
+
+struct DistanceOptions
+{
+	unsigned long long samples;	//on the surface per direction, 0: as many as the triangles sampled, 10000 at least
+	unsigned int threads;		//0: one per core
+	unsigned int seed;
+
+	DistanceOptions() { samples = 0; threads = 0; seed = 1; }
+};
+
+struct DistanceStats
+{
+	double hausdorff;
+	double rms;
+	double mean;
+	unsigned long long samples; //vertices and area samples
+};
+
+struct MeshDistance
+{
+	DistanceStats forward;	//from the samples of a to b
+	DistanceStats backward;	//from b to a
+	double hausdorff;		//symmetric
+	double rms;
+	double diagonal;		//of the bounding box of a, the distances are absolute
+};
+
+//from the surface of mesh to the triangles in bvh
+void measureOneSided(const MeshData &mesh, const TriangleBVH &bvh, const DistanceOptions &options, DistanceStats &stats);
+
+//both ways between a and b, builds a BVH for each. false if either has no live triangles
+bool measureDistance(const MeshData &a, const MeshData &b, const DistanceOptions &options, MeshDistance &distance);
+
+#endif
@@ -0,0 +1,25 @@
+/*  Synthetic meshes to stress and scale the pipeline without shipping big files:
+	 + SHAPE_SPHERE: a cube subdivided into a grid on every face and projected on the sphere
+	 + SHAPE_TERRAIN: a grid displaced by fractal noise
+	 + SHAPE_TORUS: a torus whose tube pinches into thin necks
+	 + SHAPE_SCAN: the sphere with a bumpy surface and per vertex jitter, like a raw scan
+	The triangle count is rounded to what the grid of the shape can hold. The same shape, count and seed
+	always give the same mesh.
+*/
+
+#ifndef MESHGENERATOR_H
+#define MESHGENERATOR_H
+
+class MeshData;
+
+enum MeshShape { SHAPE_SPHERE, SHAPE_TERRAIN, SHAPE_TORUS, SHAPE_SCAN };
+
+//fills the positions, normals, uvs and triangles of mesh. There is no topology: call buildTopology before
+//simplifying. False if the mesh would not fit in the index type
+bool generateMesh(MeshShape shape, unsigned long long triangles, unsigned int seed, MeshData &mesh);
+
+//"sphere", "terrain", "torus" or "scan"
+bool parseMeshShape(const char* name, MeshShape &shape);
+const char* meshShapeName(MeshShape shape);
+
+#endif
@@ -0,0 +1,24 @@
+/*  Integer type of the vertex, triangle and edge indices of a mesh. 32 bits keep the arrays compact and
+	are enough below 4G elements, define SIMPLIFICATION_INDEX64 in every project of the solution to build
+	with 64 bit indices for bigger meshes. The loaders check the counts against MESHINDEX_MAX and refuse
+	a mesh that does not fit instead of wrapping its indices around.
+*/
+
+#ifndef MESHINDEX_H
+#define MESHINDEX_H
+
+#include <stdint.h>
+#include <cstddef>
+
+#ifdef SIMPLIFICATION_INDEX64
+typedef uint64_t MeshIndex;
+#else
+typedef uint32_t MeshIndex;
+#endif
+
+#define MESHINDEX_MAX ((MeshIndex)-1)
+
+//true if count elements can be addressed, the last value is kept free as an invalid index
+inline bool fitsMeshIndex(size_t count) { return (uint64_t)count < (uint64_t)MESHINDEX_MAX; }
+
+#endif
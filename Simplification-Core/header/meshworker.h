@@ -0,0 +1,54 @@
+/*  Runs the slow mesh jobs (loading and simplifying) on a background thread so the caller never waits.
+	A job builds its result in a mesh of its own (the back buffer) and takeResult swaps it with the mesh
+	being shown in one step, so whoever renders never sees a half built mesh.
+*/
+
+#ifndef MESHWORKER_H
+#define MESHWORKER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include "meshdata.h"
+#include "threadpool.h"
+
+class MeshWorker
+{
+public:
+	MeshWorker();
+
+	//all return false if a job is running or its result has not been taken yet
+	bool load(const std::string &filename);
+	//source is copied before they return, the jobs never touch it. They use the fast engine (see fastcontraction.h)
+	bool simplify(const MeshData &source, MeshIndex targetTriangles);
+	//a chain with a level per ratio (descending, of the source triangles), see MeshData::buildLODs
+	bool buildLODs(const MeshData &source, const std::vector<float> &ratios);
+
+	bool isBusy() const;
+	float getProgress() const; //0..1 of the running job, -1 when it can't tell
+	std::string getStatus() const; //what the running job is doing, or how the last one ended
+
+	//swaps the finished mesh with front, false if there is no new one
+	bool takeResult(MeshData &front);
+	//same for a finished LOD chain
+	bool takeLODs(std::vector<MeshData> &front);
+
+private:
+	mutable std::mutex mutex;
+	enum { RESULT_NONE, RESULT_MESH, RESULT_LODS };
+
+	MeshData back;
+	std::vector<MeshData> backLods;
+	bool busy;	//a job is running or its result is waiting
+	int result;	//what is waiting to be taken
+	std::atomic<float> progress;
+	std::string status;
+
+	bool start(const std::string &status);
+	void finish(int result, const std::string &status);
+
+	ThreadPool pool; //last, so it is joined before the rest is destroyed
+};
+
+#endif
@@ -0,0 +1,48 @@
+/*  Wavefront OBJ reader. It scans the file in place and only keeps the v, vt, vn and f records,
+	the polygons are triangulated as a fan around their first corner.
+*/
+
+#ifndef OBJPARSER_H
+#define OBJPARSER_H
+
+#include <vector>
+#include "framework.h"
+
+//signed so a missing index can be -1, as wide as MeshIndex in a 64 bit build
+#ifdef SIMPLIFICATION_INDEX64
+typedef int64_t ObjIndex;
+#else
+typedef int32_t ObjIndex;
+#endif
+
+//one corner of a face, indices are 0-based and -1 when missing
+struct ObjCorner
+{
+	ObjIndex v, vt, vn;
+
+	//0: v, 1: vt, 2: vn
+	ObjIndex& component(unsigned int c) { return c == 0 ? v : (c == 1 ? vt : vn); }
+};
+
+struct ObjData
+{
+	std::vector<Vector3> positions;
+	std::vector<Vector2> uvs;
+	std::vector<Vector3> normals;
+	std::vector<ObjCorner> corners; //three per triangle
+
+	//corner components that used negative (relative) indices, as corner * 3 + component.
+	//They are resolved against the arrays of this ObjData only, so a chunk parsed on its
+	//own has to offset them once the elements of the previous chunks are known.
+	//Only meaningful while merging chunks
+	std::vector<size_t> relative;
+};
+
+//parses [begin, end) and appends the records to out
+void parseOBJ(const char* begin, const char* end, ObjData &out);
+
+//same as parseOBJ but splits the text in newline aligned chunks that are parsed concurrently
+//(0 threads means one per core). Small files are parsed on the calling thread
+void parseOBJParallel(const char* begin, const char* end, ObjData &out, unsigned int numThreads = 0);
+
+#endif
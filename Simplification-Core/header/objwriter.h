@@ -0,0 +1,18 @@
+/*  Wavefront OBJ writer. Only the vertices used by some triangle are written (renumbered) and degenerate
+	triangles are dropped, so whatever the contraction left dead never reaches the file.
+*/
+
+#ifndef OBJWRITER_H
+#define OBJWRITER_H
+
+#include <vector>
+#include <string>
+
+class MeshData;
+
+bool writeOBJ(const char* filename, const MeshData &mesh);
+
+//writes several meshes at the same time, usually the levels of a LOD chain (0 threads means one per core)
+bool writeOBJs(const std::vector<const MeshData*> &meshes, const std::vector<std::string> &filenames, unsigned int numThreads = 0);
+
+#endif
@@ -0,0 +1,34 @@
+/*  Stanford PLY reader and writer. Reads ascii and binary (little and big endian) files, keeping the
+	x y z, nx ny nz and u v (or s t, texture_u texture_v) vertex properties and the vertex_indices face list,
+	polygons are triangulated as a fan. Any other element or property is skipped.
+
+	The binary vertices are decoded a block at a time, one property column per pass with a loop specialized
+	for its type, and the faces with a loop specialized for the types of their list.
+*/
+
+#ifndef PLYFILE_H
+#define PLYFILE_H
+
+#include <vector>
+#include "framework.h"
+
+class MeshData;
+
+struct PlyData
+{
+	std::vector<Vector3> positions;
+	std::vector<Vector3> normals;	//empty, or one per position
+	std::vector<Vector2> uvs;		//empty, or one per position
+	std::vector<Triangle> triangles;
+	size_t skipped;					//faces dropped for referencing missing vertices
+
+	PlyData() { skipped = 0; }
+};
+
+//parses a whole PLY file in [begin, end), false if the header is broken or the data is truncated
+bool parsePLY(const char* begin, const char* end, PlyData &out);
+
+//writes the live triangles and the vertices they use, binary little endian unless ascii is asked for
+bool writePLY(const char* filename, const MeshData &mesh, bool binary = true);
+
+#endif
@@ -0,0 +1,29 @@
+/*  STL reader and writer. STL stores every triangle with its own three vertices, the reader welds them
+	back into indexed positions while it reads (see VertexWelder). Binary files are read record by record
+	straight from the mapped file, ascii ones are also accepted. The facet normals are ignored.
+*/
+
+#ifndef STLFILE_H
+#define STLFILE_H
+
+#include <vector>
+#include "framework.h"
+
+class MeshData;
+
+struct StlData
+{
+	std::vector<Vector3> positions;
+	std::vector<Triangle> triangles;
+	size_t skipped; //triangles dropped because two of their corners weld into the same vertex
+
+	StlData() { skipped = 0; }
+};
+
+//parses a whole STL file in [begin, end), false if it is neither a complete binary file nor an ascii one
+bool parseSTL(const char* begin, const char* end, StlData &out);
+
+//binary STL with the live triangles, the normals are computed from the corners
+bool writeSTL(const char* filename, const MeshData &mesh);
+
+#endif
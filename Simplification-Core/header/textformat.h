@@ -0,0 +1,93 @@
+/*  Small helpers to format numbers straight into a buffer, the counterpart of textscan.h.
+	Every function writes at out and returns the position after the last character written.
+*/
+
+#ifndef TEXTFORMAT_H
+#define TEXTFORMAT_H
+
+#include <cstdio>
+#include <cmath>
+
+inline char* formatUInt(char* out, unsigned long long value)
+{
+	char digits[20];
+	int n = 0;
+	do
+	{
+		digits[n++] = (char)('0' + value % 10);
+		value /= 10;
+	} while (value);
+	while (n)
+		*out++ = digits[--n];
+	return out;
+}
+
+//9 significant digits and no trailing zeros, the output of "%.9g" and enough to read back the same float.
+//Fixed notation from 1e-4 to 1e9, the rest goes through sprintf in exponent notation
+inline char* formatFloat(char* out, float value)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12 };
+
+	double v = value;
+	if (v == 0)
+	{
+		*out++ = '0';
+		return out;
+	}
+	if (!(fabs(v) >= 1e-4 && fabs(v) < 1e9)) //tiny, huge, inf or nan
+		return out + sprintf(out, "%.9g", v);
+
+	//scale to 9 digits, log10 can be one off next to a power of 10
+	double magnitude = fabs(v);
+	int exponent = (int)floor(log10(magnitude));
+	exponent = exponent < -4 ? -4 : (exponent > 8 ? 8 : exponent);
+	double scaled = magnitude * powers[8 - exponent];
+	if (scaled >= 999999999.5 && exponent < 8)
+		scaled = magnitude * powers[8 - ++exponent];
+	else if (scaled < 99999999.5 && exponent > -4)
+		scaled = magnitude * powers[8 - --exponent];
+	unsigned int digits = (unsigned int)nearbyint(scaled); //ties to even, like printf
+	if (digits >= 1000000000) //rounded up to the next power of 10
+	{
+		if (exponent == 8)
+			return out + sprintf(out, "%.9g", v);
+		digits /= 10;
+		exponent++;
+	}
+	if (v < 0)
+		*out++ = '-';
+
+	//the digits after the point are the 8 - exponent last ones
+	char text[9];
+	for (int i = 8; i >= 0; i--)
+	{
+		text[i] = (char)('0' + digits % 10);
+		digits /= 10;
+	}
+	int decimals = 8 - exponent;
+	int length = 9;
+	while (decimals > 0 && text[length - 1] == '0')
+	{
+		length--;
+		decimals--;
+	}
+
+	int integerDigits = length - decimals;
+	if (integerDigits <= 0)
+	{
+		*out++ = '0';
+		*out++ = '.';
+		for (int i = integerDigits; i < 0; i++)
+			*out++ = '0';
+		integerDigits = 0;
+	}
+	for (int i = 0; i < length; i++)
+	{
+		if (i == integerDigits && i)
+			*out++ = '.';
+		*out++ = text[i];
+	}
+	return out;
+}
+
+#endif
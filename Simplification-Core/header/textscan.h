@@ -0,0 +1,120 @@
+/*  Small helpers to scan text in place (no copies and no null terminator needed). Every function takes
+	the current position and the end of the buffer and returns the position after what it has read.
+*/
+
+#ifndef TEXTSCAN_H
+#define TEXTSCAN_H
+
+inline bool isBlank(char c) { return c == ' ' || c == '\t'; }
+inline bool isEndOfLine(char c) { return c == '\n' || c == '\r'; }
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+	while (p < end && isBlank(*p)) p++;
+	return p;
+}
+
+inline const char* skipLine(const char* p, const char* end)
+{
+	while (p < end && *p != '\n') p++;
+	return p < end ? p + 1 : p;
+}
+
+inline const char* skipToken(const char* p, const char* end)
+{
+	while (p < end && !isBlank(*p) && !isEndOfLine(*p)) p++;
+	return p;
+}
+
+//reads a signed integer, returns p unchanged if there is no number
+inline const char* scanInt(const char* p, const char* end, long long &value)
+{
+	const char* start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = (*p++ == '-');
+	if (p == end || !isDigit(*p))
+		return start;
+
+	long long result = 0;
+	while (p < end && isDigit(*p))
+		result = result * 10 + (*p++ - '0');
+	value = negative ? -result : result;
+	return p;
+}
+
+//reads a decimal number with optional exponent, returns p unchanged if there is no number
+inline const char* scanDouble(const char* p, const char* end, double &value)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	const char* start = p;
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+		negative = (*p++ == '-');
+
+	unsigned long long mantissa = 0;
+	int exponent = 0;
+	int digits = 0;
+	bool any = false;
+
+	while (p < end && isDigit(*p))
+	{
+		//beyond 19 digits the value does not fit, the extra ones only scale it
+		if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; }
+		else exponent++;
+		p++;
+		any = true;
+	}
+	if (p < end && *p == '.')
+	{
+		p++;
+		while (p < end && isDigit(*p))
+		{
+			if (digits < 19) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; exponent--; }
+			p++;
+			any = true;
+		}
+	}
+	if (!any)
+		return start;
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		long long e = 0;
+		const char* after = scanInt(p + 1, end, e);
+		if (after != p + 1)
+		{
+			exponent += (int)e;
+			p = after;
+		}
+	}
+
+	double result = (double)mantissa;
+	if (exponent < 0)
+	{
+		while (exponent < -22) { result /= 1e22; exponent += 22; }
+		result /= powers[-exponent];
+	}
+	else
+	{
+		while (exponent > 22) { result *= 1e22; exponent -= 22; }
+		result *= powers[exponent];
+	}
+
+	value = negative ? -result : result;
+	return p;
+}
+
+inline const char* scanFloat(const char* p, const char* end, float &value)
+{
+	double d = 0;
+	const char* after = scanDouble(p, end, d);
+	if (after != p)
+		value = (float)d;
+	return after;
+}
+
+#endif
@@ -0,0 +1,39 @@
+/*  A fixed set of worker threads that run queued jobs. Used to process several meshes at the same time
+	and to split the big loops of a single mesh.
+*/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+class ThreadPool
+{
+public:
+	//0 threads means one per hardware core
+	ThreadPool(unsigned int numThreads = 0);
+	~ThreadPool();
+
+	void enqueue(const std::function<void()> &job);
+	void wait(); //blocks until every queued job has finished
+
+	unsigned int size() const { return (unsigned int)workers.size(); }
+
+private:
+	std::vector<std::thread> workers;
+	std::deque< std::function<void()> > jobs;
+	std::mutex mutex;
+	std::condition_variable jobAvailable;
+	std::condition_variable jobsDone;
+	unsigned int running;
+	bool stopping;
+
+	void workerLoop();
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*  Tracing of the pipeline in the Chrome trace event format (chrome://tracing, Perfetto).
+	 + TRACE_SCOPE(name) records the time spent in the rest of the block as a phase
+	 + TRACE_COUNT(name, n) adds to a counter, a relaxed atomic add so it can sit in the hot loops
+	 + TRACE_SAMPLE() records the value of every counter, for the curves in the viewer
+	All of them compile to nothing unless SIMPLIFICATION_TRACE is defined. Phases are only recorded between
+	traceStart and traceWrite, counters count all the time and traceStart sets them back to 0.
+	Names must be string literals.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+//false when tracing is not compiled in
+bool traceStart();
+//writes what was recorded since traceStart and stops recording
+bool traceWrite(const char* filename);
+
+#ifdef SIMPLIFICATION_TRACE
+
+#include <atomic>
+
+class TraceCounter
+{
+public:
+	TraceCounter(const char* name); //registers it, counters with the same name are added up
+	void add(unsigned long long n) { value.fetch_add(n, std::memory_order_relaxed); }
+
+	const char* name;
+	std::atomic<unsigned long long> value;
+	TraceCounter* next;
+};
+
+class TraceScope
+{
+public:
+	TraceScope(const char* name);
+	~TraceScope();
+
+private:
+	const char* name;
+	long long start; //microseconds, -1 when not recording
+};
+
+void traceSampleCounters();
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_COUNT(name, n) do { static TraceCounter traceCounter(name); traceCounter.add(n); } while (0)
+#define TRACE_SAMPLE() traceSampleCounters()
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_COUNT(name, n) do {} while (0)
+#define TRACE_SAMPLE() do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+/*  Merges vertices with the same position while they are added, for formats that store every triangle
+	with its own copies of the vertices. Positions live in an open addressing hash table of indices,
+	so each add is constant time and the memory grows with the unique vertices only.
+	Positions are compared exactly (0 and -0 are the same vertex).
+*/
+
+#ifndef VERTEXWELDER_H
+#define VERTEXWELDER_H
+
+#include <vector>
+#include "framework.h"
+
+class VertexWelder
+{
+public:
+	//the unique positions are appended to positions, the ones already there are kept as they are
+	VertexWelder(std::vector<Vector3> &positions);
+
+	//index of p in positions, appending it if it wasn't there
+	MeshIndex add(const Vector3 &p);
+
+private:
+	std::vector<Vector3> &positions;
+	std::vector<MeshIndex> table; //index in positions, or empty
+	size_t mask;
+
+	void rehash(size_t size);
+	size_t slot(const Vector3 &p) const;
+};
+
+#endif
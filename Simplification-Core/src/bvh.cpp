@@ -0,0 +1,660 @@
+#include "bvh.h"
+#include "meshdata.h"
+#include "threadpool.h"
+
+#include <algorithm>
+#include <functional>
+#include <cfloat>
+
+//it can't get deeper than the median splits past BVH_MAX_DEPTH allow
+#define BVH_STACK (BVH_MAX_DEPTH + 64)
+#define BVH_BATCH_CHUNK 1024 //queries per job of the batches
+
+struct BuildTriangle
+{
+	Vector3 min;
+	Vector3 max;
+	Vector3 center;
+	MeshIndex index;
+};
+
+//a subtree, flattened on its own and spliced in afterwards
+struct BuildOutput
+{
+	std::vector<TriangleBVH::Node> nodes;
+	std::vector<MeshIndex> triangles;
+};
+
+//the top of the tree when it is built in parallel, down to the subtrees given to the threads
+struct TopNode
+{
+	Vector3 min;
+	Vector3 max;
+	int children[2];	//in the top nodes, -1 when it is a subtree
+	int subtree;
+};
+
+static float surfaceArea(const Vector3 &min, const Vector3 &max)
+{
+	Vector3 d = max - min;
+	return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+static void growBox(Vector3 &min, Vector3 &max, const Vector3 &boxMin, const Vector3 &boxMax)
+{
+	min = Vector3(std::min(min.x, boxMin.x), std::min(min.y, boxMin.y), std::min(min.z, boxMin.z));
+	max = Vector3(std::max(max.x, boxMax.x), std::max(max.y, boxMax.y), std::max(max.z, boxMax.z));
+}
+
+//squared, 0 inside
+static double boxDistance(const DVector3 &p, const Vector3 &min, const Vector3 &max)
+{
+	double dx = std::max(0.0, std::max(min.x - p.x, p.x - max.x));
+	double dy = std::max(0.0, std::max(min.y - p.y, p.y - max.y));
+	double dz = std::max(0.0, std::max(min.z - p.z, p.z - max.z));
+	return dx * dx + dy * dy + dz * dz;
+}
+
+static bool boxesOverlap(const Vector3 &minA, const Vector3 &maxA, const Vector3 &minB, const Vector3 &maxB)
+{
+	return minA.x <= maxB.x && maxA.x >= minB.x && minA.y <= maxB.y && maxA.y >= minB.y && minA.z <= maxB.z && maxA.z >= minB.z;
+}
+
+//where the ray enters the box, false if it misses it before maxT
+static bool rayBox(const DVector3 &origin, const DVector3 &inverse, double maxT, const Vector3 &min, const Vector3 &max, double &tEnter)
+{
+	double t0 = (min.x - origin.x) * inverse.x, t1 = (max.x - origin.x) * inverse.x;
+	double tNear = std::min(t0, t1), tFar = std::max(t0, t1);
+	t0 = (min.y - origin.y) * inverse.y;
+	t1 = (max.y - origin.y) * inverse.y;
+	tNear = std::max(tNear, std::min(t0, t1));
+	tFar = std::min(tFar, std::max(t0, t1));
+	t0 = (min.z - origin.z) * inverse.z;
+	t1 = (max.z - origin.z) * inverse.z;
+	tNear = std::max(tNear, std::min(t0, t1));
+	tFar = std::min(tFar, std::max(t0, t1));
+	tEnter = std::max(tNear, 0.0);
+	return tNear <= tFar && tFar >= 0 && tEnter <= maxT;
+}
+
+//Moller and Trumbore, both sides
+static bool rayTriangle(const DVector3 &origin, const DVector3 &direction, const DVector3 &a, const DVector3 &b, const DVector3 &c,
+	double &t, double &u, double &v)
+{
+	DVector3 ab = b - a, ac = c - a;
+	DVector3 p = direction.cross(ac);
+	double determinant = ab.dot(p);
+	if (determinant == 0)
+		return false;
+	double inverse = 1 / determinant;
+	DVector3 s = origin - a;
+	u = s.dot(p) * inverse;
+	if (u < 0 || u > 1)
+		return false;
+	DVector3 q = s.cross(ab);
+	v = direction.dot(q) * inverse;
+	if (v < 0 || u + v > 1)
+		return false;
+	t = ac.dot(q) * inverse;
+	return t >= 0;
+}
+
+//separating axes of a triangle and a box: the box faces, the triangle plane and the 9 edge crossings
+//(Akenine-Moller, Fast 3D Triangle-Box Overlap Testing)
+static bool triangleOverlapsBox(const Vector3 &a, const Vector3 &b, const Vector3 &c, const Vector3 &min, const Vector3 &max)
+{
+	DVector3 center = (DVector3(min) + DVector3(max)) * 0.5, half = (DVector3(max) - DVector3(min)) * 0.5;
+	DVector3 v[3] = { DVector3(a) - center, DVector3(b) - center, DVector3(c) - center };
+	const double* halfAxes = &half.x;
+	for (int k = 0; k < 3; k++)
+	{
+		double p0 = (&v[0].x)[k], p1 = (&v[1].x)[k], p2 = (&v[2].x)[k];
+		if (std::min(p0, std::min(p1, p2)) > halfAxes[k] || std::max(p0, std::max(p1, p2)) < -halfAxes[k])
+			return false;
+	}
+
+	DVector3 edges[3] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] };
+	DVector3 normal = edges[0].cross(edges[1]);
+	if (fabs(normal.dot(v[0])) > half.x * fabs(normal.x) + half.y * fabs(normal.y) + half.z * fabs(normal.z))
+		return false;
+
+	const DVector3 boxAxes[3] = { DVector3(1, 0, 0), DVector3(0, 1, 0), DVector3(0, 0, 1) };
+	for (int e = 0; e < 3; e++)
+		for (int k = 0; k < 3; k++)
+		{
+			DVector3 axis = boxAxes[k].cross(edges[e]);
+			double p0 = axis.dot(v[0]), p1 = axis.dot(v[1]), p2 = axis.dot(v[2]);
+			double radius = half.x * fabs(axis.x) + half.y * fabs(axis.y) + half.z * fabs(axis.z);
+			if (std::min(p0, std::min(p1, p2)) > radius || std::max(p0, std::max(p1, p2)) < -radius)
+				return false;
+		}
+	return true;
+}
+
+//Ericson, Real-Time Collision Detection 5.1.5
+DVector3 closestOnTriangle(const DVector3 &p, const DVector3 &a, const DVector3 &b, const DVector3 &c)
+{
+	DVector3 ab = b - a, ac = c - a, ap = p - a;
+	double d1 = ab.dot(ap), d2 = ac.dot(ap);
+	if (d1 <= 0 && d2 <= 0)
+		return a;
+
+	DVector3 bp = p - b;
+	double d3 = ab.dot(bp), d4 = ac.dot(bp);
+	if (d3 >= 0 && d4 <= d3)
+		return b;
+
+	double vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		return a + ab * (d1 / (d1 - d3));
+
+	DVector3 cp = p - c;
+	double d5 = ab.dot(cp), d6 = ac.dot(cp);
+	if (d6 >= 0 && d5 <= d6)
+		return c;
+
+	double vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		return a + ac * (d2 / (d2 - d6));
+
+	double va = d3 * d6 - d5 * d4;
+	if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0)
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	double denominator = 1 / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+//the box of items [first, first + count) and where they split, first + count when they make a leaf
+static MeshIndex partitionNode(std::vector<BuildTriangle> &items, MeshIndex first, MeshIndex count, unsigned int depth, Vector3 &min, Vector3 &max)
+{
+	min = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+	max = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	Vector3 centerMin = min, centerMax = max;
+	for (MeshIndex i = first; i < first + count; i++)
+	{
+		growBox(min, max, items[i].min, items[i].max);
+		growBox(centerMin, centerMax, items[i].center, items[i].center);
+	}
+	if (count <= BVH_LEAF_TRIANGLES)
+		return first + count;
+
+	Vector3 extent = centerMax - centerMin;
+	int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+	float axisMin = centerMin.v[axis], axisExtent = extent.v[axis];
+	BuildTriangle* begin = &items[0] + first;
+	BuildTriangle* end = begin + count;
+
+	if (axisExtent > 0 && depth < BVH_MAX_DEPTH)
+	{
+		MeshIndex binCount[BVH_BINS] = {};
+		Vector3 binMin[BVH_BINS], binMax[BVH_BINS];
+		for (int b = 0; b < BVH_BINS; b++)
+		{
+			binMin[b] = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+			binMax[b] = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		}
+		float scale = BVH_BINS / axisExtent;
+		for (BuildTriangle* item = begin; item != end; item++)
+		{
+			int b = std::min(BVH_BINS - 1, (int)((item->center.v[axis] - axisMin) * scale));
+			binCount[b]++;
+			growBox(binMin[b], binMax[b], item->min, item->max);
+		}
+
+		//the cost of splitting after every bin, the areas from the right first
+		float rightCost[BVH_BINS];
+		Vector3 sweepMin(FLT_MAX, FLT_MAX, FLT_MAX), sweepMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		MeshIndex sweepCount = 0;
+		for (int b = BVH_BINS - 1; b > 0; b--)
+		{
+			sweepCount += binCount[b];
+			if (binCount[b])
+				growBox(sweepMin, sweepMax, binMin[b], binMax[b]);
+			rightCost[b] = sweepCount ? surfaceArea(sweepMin, sweepMax) * sweepCount : 0;
+		}
+		sweepMin = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+		sweepMax = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		sweepCount = 0;
+		float bestCost = FLT_MAX;
+		int bestBin = -1;
+		for (int b = 0; b < BVH_BINS - 1; b++)
+		{
+			sweepCount += binCount[b];
+			if (binCount[b])
+				growBox(sweepMin, sweepMax, binMin[b], binMax[b]);
+			if (sweepCount == 0 || sweepCount == count)
+				continue;
+			float cost = surfaceArea(sweepMin, sweepMax) * sweepCount + rightCost[b + 1];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestBin = b;
+			}
+		}
+
+		if (bestBin >= 0)
+		{
+			BuildTriangle* cut = std::partition(begin, end, [&](const BuildTriangle &item) {
+				return std::min(BVH_BINS - 1, (int)((item.center.v[axis] - axisMin) * scale)) <= bestBin; });
+			MeshIndex middle = first + (MeshIndex)(cut - begin);
+			if (middle > first && middle < first + count)
+				return middle;
+		}
+	}
+
+	//too deep or every center in the same place
+	std::nth_element(begin, begin + count / 2, end, [axis](const BuildTriangle &a, const BuildTriangle &b) {
+		return a.center.v[axis] < b.center.v[axis]; });
+	return first + count / 2;
+}
+
+static MeshIndex buildSubtree(BuildOutput &out, std::vector<BuildTriangle> &items, MeshIndex first, MeshIndex count, unsigned int depth)
+{
+	MeshIndex index = (MeshIndex)out.nodes.size();
+	out.nodes.push_back(TriangleBVH::Node());
+	Vector3 min, max;
+	MeshIndex middle = partitionNode(items, first, count, depth, min, max);
+	out.nodes[index].min = min;
+	out.nodes[index].max = max;
+	if (middle == first + count)
+	{
+		out.nodes[index].offset = (MeshIndex)out.triangles.size();
+		out.nodes[index].count = count;
+		for (MeshIndex i = first; i < first + count; i++)
+			out.triangles.push_back(items[i].index);
+		return index;
+	}
+
+	buildSubtree(out, items, first, middle - first, depth + 1);
+	MeshIndex second = buildSubtree(out, items, middle, first + count - middle, depth + 1);
+	out.nodes[index].offset = second;
+	out.nodes[index].count = 0;
+	return index;
+}
+
+TriangleBVH::TriangleBVH()
+{
+}
+
+void TriangleBVH::build(const MeshData &mesh, unsigned int threads)
+{
+	this->nodes.clear();
+	this->corners.clear();
+	this->triangles.clear();
+
+	std::vector<BuildTriangle> items;
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		if (!mesh.isLiveTriangle(tri))
+			continue;
+		const Vector3 &a = mesh.indexed_positions[tri.i], &b = mesh.indexed_positions[tri.j], &c = mesh.indexed_positions[tri.k];
+		BuildTriangle item;
+		item.min = item.max = a;
+		growBox(item.min, item.max, b, b);
+		growBox(item.min, item.max, c, c);
+		item.center = (item.min + item.max) * 0.5f;
+		item.index = (MeshIndex)t;
+		items.push_back(item);
+	}
+	if (items.empty())
+		return;
+
+	//a binary tree with leaves of at least one triangle has fewer than 2n nodes
+	this->nodes.reserve(items.size() * 2);
+	this->triangles.reserve(items.size());
+	if (threads == 1 || items.size() <= BVH_PARALLEL_TRIANGLES)
+	{
+		BuildOutput out;
+		out.nodes.swap(this->nodes);
+		out.triangles.swap(this->triangles);
+		buildSubtree(out, items, 0, (MeshIndex)items.size(), 0);
+		this->nodes.swap(out.nodes);
+		this->triangles.swap(out.triangles);
+	}
+	else
+	{
+		//the top levels split here, the subtrees below BVH_PARALLEL_TRIANGLES build on the pool on their own ranges
+		std::vector<TopNode> top;
+		std::vector<BuildOutput> subtrees;
+		struct SubtreeRange { MeshIndex first, count; unsigned int depth; };
+		std::vector<SubtreeRange> ranges;
+		std::function<int(MeshIndex, MeshIndex, unsigned int)> splitTop = [&](MeshIndex first, MeshIndex count, unsigned int depth) {
+			int index = (int)top.size();
+			top.push_back(TopNode());
+			top[index].children[0] = top[index].children[1] = -1;
+			top[index].subtree = -1;
+			if (count <= BVH_PARALLEL_TRIANGLES)
+			{
+				top[index].subtree = (int)ranges.size();
+				SubtreeRange range = { first, count, depth };
+				ranges.push_back(range);
+				return index;
+			}
+			Vector3 min, max;
+			MeshIndex middle = partitionNode(items, first, count, depth, min, max);
+			top[index].min = min;
+			top[index].max = max;
+			int left = splitTop(first, middle - first, depth + 1);
+			int right = splitTop(middle, first + count - middle, depth + 1);
+			top[index].children[0] = left;
+			top[index].children[1] = right;
+			return index;
+		};
+		splitTop(0, (MeshIndex)items.size(), 0);
+
+		subtrees.resize(ranges.size());
+		{
+			ThreadPool pool(threads);
+			for (size_t s = 0; s < ranges.size(); s++)
+				pool.enqueue([&, s]() { buildSubtree(subtrees[s], items, ranges[s].first, ranges[s].count, ranges[s].depth); });
+			pool.wait();
+		}
+
+		//depth first again, every subtree copied where its top node was with its offsets moved
+		std::function<void(int)> flatten = [&](int t) {
+			if (top[t].subtree >= 0)
+			{
+				BuildOutput &subtree = subtrees[top[t].subtree];
+				MeshIndex nodeBase = (MeshIndex)this->nodes.size(), triangleBase = (MeshIndex)this->triangles.size();
+				for (size_t n = 0; n < subtree.nodes.size(); n++)
+				{
+					Node node = subtree.nodes[n];
+					node.offset += node.count ? triangleBase : nodeBase;
+					this->nodes.push_back(node);
+				}
+				this->triangles.insert(this->triangles.end(), subtree.triangles.begin(), subtree.triangles.end());
+				std::vector<Node>().swap(subtree.nodes);
+				return;
+			}
+			MeshIndex index = (MeshIndex)this->nodes.size();
+			Node node;
+			node.min = top[t].min;
+			node.max = top[t].max;
+			node.count = 0;
+			this->nodes.push_back(node);
+			flatten(top[t].children[0]);
+			this->nodes[index].offset = (MeshIndex)this->nodes.size();
+			flatten(top[t].children[1]);
+		};
+		flatten(0);
+	}
+
+	this->corners.resize(this->triangles.size() * 3);
+	this->refit(mesh);
+}
+
+bool TriangleBVH::refit(const MeshData &mesh)
+{
+	//all checked before anything is written, a false return leaves the tree as it was
+	for (size_t t = 0; t < this->triangles.size(); t++)
+		if (this->triangles[t] >= mesh.triangles.size() || !mesh.isLiveTriangle(mesh.triangles[this->triangles[t]]))
+			return false;
+
+	for (size_t t = 0; t < this->triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[this->triangles[t]];
+		this->corners[t * 3] = mesh.indexed_positions[tri.i];
+		this->corners[t * 3 + 1] = mesh.indexed_positions[tri.j];
+		this->corners[t * 3 + 2] = mesh.indexed_positions[tri.k];
+	}
+
+	//children are always after their parent
+	for (size_t n = this->nodes.size(); n-- > 0;)
+	{
+		Node &node = this->nodes[n];
+		node.min = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+		node.max = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		if (node.count)
+		{
+			for (MeshIndex c = node.offset * 3; c < (node.offset + node.count) * 3; c++)
+				growBox(node.min, node.max, this->corners[c], this->corners[c]);
+		}
+		else
+		{
+			growBox(node.min, node.max, this->nodes[n + 1].min, this->nodes[n + 1].max);
+			growBox(node.min, node.max, this->nodes[node.offset].min, this->nodes[node.offset].max);
+		}
+	}
+	return true;
+}
+
+size_t TriangleBVH::memoryBytes() const
+{
+	return this->nodes.capacity() * sizeof(Node) + this->corners.capacity() * sizeof(Vector3) + this->triangles.capacity() * sizeof(MeshIndex);
+}
+
+bool TriangleBVH::closest(const DVector3 &p, DVector3 &point, MeshIndex &triangle) const
+{
+	if (this->nodes.empty())
+		return false;
+
+	//nearest child last so it is searched first, nodes farther than the best found are skipped
+	MeshIndex stack[BVH_STACK];
+	double stackDistance[BVH_STACK];
+	int size = 0;
+	double best = DBL_MAX;
+	stack[size] = 0;
+	stackDistance[size++] = boxDistance(p, this->nodes[0].min, this->nodes[0].max);
+	while (size > 0)
+	{
+		size--;
+		if (stackDistance[size] >= best)
+			continue;
+		const Node &node = this->nodes[stack[size]];
+		if (node.count)
+		{
+			for (MeshIndex t = node.offset; t < node.offset + node.count; t++)
+			{
+				const Vector3* c = &this->corners[t * 3];
+				DVector3 q = closestOnTriangle(p, DVector3(c[0]), DVector3(c[1]), DVector3(c[2]));
+				double distance = (q - p).dot(q - p);
+				if (distance < best)
+				{
+					best = distance;
+					point = q;
+					triangle = this->triangles[t];
+				}
+			}
+			continue;
+		}
+
+		MeshIndex nearChild = stack[size] + 1, farChild = node.offset;
+		double nearDistance = boxDistance(p, this->nodes[nearChild].min, this->nodes[nearChild].max);
+		double farDistance = boxDistance(p, this->nodes[farChild].min, this->nodes[farChild].max);
+		if (farDistance < nearDistance)
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearDistance, farDistance);
+		}
+		if (farDistance < best)
+		{
+			stack[size] = farChild;
+			stackDistance[size++] = farDistance;
+		}
+		if (nearDistance < best)
+		{
+			stack[size] = nearChild;
+			stackDistance[size++] = nearDistance;
+		}
+	}
+	return true;
+}
+
+bool TriangleBVH::intersectRay(const DVector3 &origin, const DVector3 &direction, double maxT, BVHRayHit &hit) const
+{
+	hit.found = false;
+	if (this->nodes.empty())
+		return false;
+
+	//a 0 component gives an infinite inverse, the slabs of that axis then hold everything or nothing
+	DVector3 inverse(1 / direction.x, 1 / direction.y, 1 / direction.z);
+	MeshIndex stack[BVH_STACK];
+	double stackEnter[BVH_STACK];
+	int size = 0;
+	double best = maxT, enter;
+	if (!rayBox(origin, inverse, best, this->nodes[0].min, this->nodes[0].max, enter))
+		return false;
+	stack[size] = 0;
+	stackEnter[size++] = enter;
+	while (size > 0)
+	{
+		size--;
+		if (stackEnter[size] > best)
+			continue;
+		const Node &node = this->nodes[stack[size]];
+		if (node.count)
+		{
+			for (MeshIndex t = node.offset; t < node.offset + node.count; t++)
+			{
+				const Vector3* c = &this->corners[t * 3];
+				double tHit, u, v;
+				if (rayTriangle(origin, direction, DVector3(c[0]), DVector3(c[1]), DVector3(c[2]), tHit, u, v) && tHit <= best)
+				{
+					best = tHit;
+					hit.t = tHit;
+					hit.u = u;
+					hit.v = v;
+					hit.triangle = this->triangles[t];
+					hit.found = true;
+				}
+			}
+			continue;
+		}
+
+		MeshIndex nearChild = stack[size] + 1, farChild = node.offset;
+		double nearEnter, farEnter;
+		bool nearHit = rayBox(origin, inverse, best, this->nodes[nearChild].min, this->nodes[nearChild].max, nearEnter);
+		bool farHit = rayBox(origin, inverse, best, this->nodes[farChild].min, this->nodes[farChild].max, farEnter);
+		if (farHit && (!nearHit || farEnter < nearEnter))
+		{
+			std::swap(nearChild, farChild);
+			std::swap(nearEnter, farEnter);
+			std::swap(nearHit, farHit);
+		}
+		if (farHit)
+		{
+			stack[size] = farChild;
+			stackEnter[size++] = farEnter;
+		}
+		if (nearHit)
+		{
+			stack[size] = nearChild;
+			stackEnter[size++] = nearEnter;
+		}
+	}
+	return hit.found;
+}
+
+void TriangleBVH::overlapBox(const Vector3 &min, const Vector3 &max, std::vector<MeshIndex> &triangles) const
+{
+	if (this->nodes.empty())
+		return;
+
+	MeshIndex stack[BVH_STACK];
+	int size = 0;
+	stack[size++] = 0;
+	while (size > 0)
+	{
+		MeshIndex index = stack[--size];
+		const Node &node = this->nodes[index];
+		if (!boxesOverlap(node.min, node.max, min, max))
+			continue;
+		if (node.count)
+		{
+			for (MeshIndex t = node.offset; t < node.offset + node.count; t++)
+			{
+				const Vector3* c = &this->corners[t * 3];
+				if (triangleOverlapsBox(c[0], c[1], c[2], min, max))
+					triangles.push_back(this->triangles[t]);
+			}
+			continue;
+		}
+		stack[size++] = node.offset;
+		stack[size++] = index + 1;
+	}
+}
+
+//spreads the 10 low bits of v to every third bit
+static unsigned int spreadBits(unsigned int v)
+{
+	v = (v | (v << 16)) & 0x030000FF;
+	v = (v | (v << 8)) & 0x0300F00F;
+	v = (v | (v << 4)) & 0x030C30C3;
+	v = (v | (v << 2)) & 0x09249249;
+	return v;
+}
+
+void TriangleBVH::mortonOrder(const std::vector<DVector3> &points, std::vector<size_t> &order) const
+{
+	DVector3 min(this->nodes[0].min), extent = DVector3(this->nodes[0].max) - min;
+	DVector3 scale(extent.x > 0 ? 1023 / extent.x : 0, extent.y > 0 ? 1023 / extent.y : 0, extent.z > 0 ? 1023 / extent.z : 0);
+	std::vector<std::pair<unsigned int, size_t> > codes(points.size());
+	for (size_t i = 0; i < points.size(); i++)
+	{
+		//the ones outside the bounds go to its faces
+		unsigned int x = (unsigned int)std::max(0.0, std::min(1023.0, (points[i].x - min.x) * scale.x));
+		unsigned int y = (unsigned int)std::max(0.0, std::min(1023.0, (points[i].y - min.y) * scale.y));
+		unsigned int z = (unsigned int)std::max(0.0, std::min(1023.0, (points[i].z - min.z) * scale.z));
+		codes[i] = std::make_pair(spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2), i);
+	}
+	std::sort(codes.begin(), codes.end());
+	order.resize(points.size());
+	for (size_t i = 0; i < codes.size(); i++)
+		order[i] = codes[i].second;
+}
+
+//runs query(i) for every i in order, in chunks on a pool
+static void runBatch(const std::vector<size_t> &order, unsigned int threads, const std::function<void(size_t)> &query)
+{
+	size_t numChunks = (order.size() + BVH_BATCH_CHUNK - 1) / BVH_BATCH_CHUNK;
+	auto runChunk = [&](size_t c) {
+		size_t end = std::min(order.size(), (c + 1) * BVH_BATCH_CHUNK);
+		for (size_t i = c * BVH_BATCH_CHUNK; i < end; i++)
+			query(order[i]);
+	};
+	if (threads == 1 || numChunks <= 1)
+	{
+		for (size_t c = 0; c < numChunks; c++)
+			runChunk(c);
+		return;
+	}
+	ThreadPool pool(threads);
+	for (size_t c = 0; c < numChunks; c++)
+		pool.enqueue([&, c]() { runChunk(c); });
+	pool.wait();
+}
+
+void TriangleBVH::closestBatch(const std::vector<DVector3> &points, std::vector<BVHClosestHit> &hits, unsigned int threads) const
+{
+	hits.resize(points.size());
+	if (this->nodes.empty())
+	{
+		for (size_t i = 0; i < hits.size(); i++)
+			hits[i].found = false;
+		return;
+	}
+	std::vector<size_t> order;
+	this->mortonOrder(points, order);
+	runBatch(order, threads, [&](size_t i) {
+		BVHClosestHit &hit = hits[i];
+		hit.found = this->closest(points[i], hit.point, hit.triangle);
+		hit.distance = hit.found ? (hit.point - points[i]).dot(hit.point - points[i]) : DBL_MAX;
+	});
+}
+
+void TriangleBVH::intersectRays(const std::vector<DVector3> &origins, const std::vector<DVector3> &directions, double maxT,
+	std::vector<BVHRayHit> &hits, unsigned int threads) const
+{
+	hits.resize(origins.size());
+	if (this->nodes.empty())
+	{
+		for (size_t i = 0; i < hits.size(); i++)
+			hits[i].found = false;
+		return;
+	}
+	std::vector<size_t> order;
+	this->mortonOrder(origins, order);
+	runBatch(order, threads, [&](size_t i) { this->intersectRay(origins[i], directions[i], maxT, hits[i]); });
+}
@@ -0,0 +1,603 @@
+#include "fastcontraction.h"
+#include "meshdata.h"
+#include "trace.h"
+#include "memorystats.h"
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#define BOUNDARY_WEIGHT 10.0	//of the plane along a border edge, a triangle plane weighs 1
+#define ANCHOR_WEIGHT 0.000001	//of the distance to the position of the vertex, breaks the ties of flat areas
+#define MEMORY_WEIGHT 0.15		//of the planes of the loaded mesh against the ones of the current triangles
+#define NO_CORNER ((MeshIndex)-1)
+
+//symmetric 4x4 matrix of the squared distance to a set of planes, only the upper half is stored
+struct Quadric
+{
+	double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+
+	Quadric() { a2 = ab = ac = ad = b2 = bc = bd = c2 = cd = d2 = 0; }
+
+	//plane n.p + d = 0 with n unit
+	void addPlane(const DVector3 &n, double d, double weight)
+	{
+		a2 += weight * n.x * n.x; ab += weight * n.x * n.y; ac += weight * n.x * n.z; ad += weight * n.x * d;
+		b2 += weight * n.y * n.y; bc += weight * n.y * n.z; bd += weight * n.y * d;
+		c2 += weight * n.z * n.z; cd += weight * n.z * d;
+		d2 += weight * d * d;
+	}
+
+	void add(const Quadric &q, double weight = 1)
+	{
+		a2 += weight * q.a2; ab += weight * q.ab; ac += weight * q.ac; ad += weight * q.ad; b2 += weight * q.b2;
+		bc += weight * q.bc; bd += weight * q.bd; c2 += weight * q.c2; cd += weight * q.cd; d2 += weight * q.d2;
+	}
+
+	//the plane through the edge pq perpendicular to a triangle with that normal (not unit)
+	void addBorder(const DVector3 &p, const DVector3 &q, const DVector3 &triangleNormal)
+	{
+		DVector3 normal = (q - p).cross(triangleNormal);
+		double length = sqrt(normal.dot(normal));
+		if (length == 0)
+			return;
+		normal = normal * (1 / length);
+		this->addPlane(normal, -normal.dot(p), BOUNDARY_WEIGHT);
+	}
+
+	//a point quadric, the squared distance to p
+	void addAnchor(const DVector3 &p, double weight)
+	{
+		this->addPlane(DVector3(1, 0, 0), -p.x, weight);
+		this->addPlane(DVector3(0, 1, 0), -p.y, weight);
+		this->addPlane(DVector3(0, 0, 1), -p.z, weight);
+	}
+
+	double evaluate(const DVector3 &p) const
+	{
+		return p.x * (a2 * p.x + 2 * (ab * p.y + ac * p.z + ad)) + p.y * (b2 * p.y + 2 * (bc * p.z + bd)) +
+			p.z * (c2 * p.z + 2 * cd) + d2;
+	}
+
+	//where the error is the smallest, false if the planes don't fix a single point
+	bool minimum(DVector3 &p) const
+	{
+		double c00 = b2 * c2 - bc * bc, c01 = ac * bc - ab * c2, c02 = ab * bc - ac * b2;
+		double det = a2 * c00 + ab * c01 + ac * c02;
+		double trace = a2 + b2 + c2;
+		if (fabs(det) <= 1e-9 * trace * trace * trace)
+			return false;
+		double c11 = a2 * c2 - ac * ac, c12 = ab * ac - a2 * bc, c22 = a2 * b2 - ab * ab;
+		p.x = -(c00 * ad + c01 * bd + c02 * cd) / det;
+		p.y = -(c01 * ad + c11 * bd + c12 * cd) / det;
+		p.z = -(c02 * ad + c12 * bd + c22 * cd) / det;
+		return true;
+	}
+};
+
+//a contraction of v into u, valid while neither of them changes
+struct Candidate
+{
+	double cost;
+	Vector3 position; //float like the mesh, it keeps the heap small
+	MeshIndex u, v;
+	unsigned int stampU, stampV;
+};
+
+//for a heap with the cheapest on top
+struct MoreCost
+{
+	bool operator()(const Candidate &a, const Candidate &b) const
+	{
+		return a.cost > b.cost;
+	}
+};
+
+struct EdgeKey
+{
+	MeshIndex a, b; //a < b
+	MeshIndex triangle;
+
+	bool operator < (const EdgeKey &e) const { return a != e.a ? a < e.a : b < e.b; }
+};
+
+class FastContraction
+{
+public:
+	FastContraction(MeshData &mesh);
+	MeshIndex run(MeshIndex targetTriangles, double maxError);
+
+private:
+	MeshData &mesh;
+	std::vector<DVector3> positions;
+	//the planes of the loaded triangles the vertex stands for, summed by the contractions
+	std::vector<Quadric> quadrics;
+	//the planes of the triangles around the vertex now, what the cost mostly follows
+	std::vector<Quadric> surfaceQuadrics;
+	std::vector<MeshIndex> corners;		//3 per triangle
+	std::vector<char> deadTriangles;
+	std::vector<char> removedVertices;
+	std::vector<unsigned int> stamps;	//changes every time the vertex does
+	//the corners of every vertex as a linked list, so merging two is a splice
+	std::vector<MeshIndex> firstCorner;
+	std::vector<MeshIndex> nextCorner;
+	std::vector<Candidate> heap;
+	MeshIndex liveTriangles;
+
+	//scratch of the contraction being checked
+	std::vector<MeshIndex> trianglesU, trianglesV, neighborsU, neighborsV, ring;
+
+	void setup();
+	void updateSurfaceQuadric(MeshIndex v);
+	void push(MeshIndex u, MeshIndex v);
+	bool isStale(const Candidate &c) const;
+	void gatherTriangles(MeshIndex v, std::vector<MeshIndex> &triangles);
+	void gatherNeighbors(MeshIndex v, MeshIndex skip, const std::vector<MeshIndex> &triangles, std::vector<MeshIndex> &neighbors) const;
+	bool isValid(const Candidate &c);
+	bool flips(const std::vector<MeshIndex> &triangles, MeshIndex moved, MeshIndex other, const Vector3 &position) const;
+	void contract(const Candidate &c);
+	void sampleMemory();
+	void writeBack();
+};
+
+FastContraction::FastContraction(MeshData &mesh) : mesh(mesh)
+{
+	liveTriangles = 0;
+}
+
+void FastContraction::setup()
+{
+	MeshIndex numVertices = mesh.indexed_positions.size();
+	MeshIndex numTriangles = mesh.triangles.size();
+
+	positions.resize(numVertices);
+	quadrics.resize(numVertices);
+	for (MeshIndex v = 0; v < numVertices; v++)
+	{
+		positions[v] = DVector3(mesh.indexed_positions[v]);
+		quadrics[v].addAnchor(positions[v], ANCHOR_WEIGHT);
+	}
+	removedVertices.assign(numVertices, 0);
+	stamps.assign(numVertices, 0);
+	firstCorner.assign(numVertices, NO_CORNER);
+	nextCorner.resize(numTriangles * 3);
+	corners.resize(numTriangles * 3);
+	deadTriangles.resize(numTriangles);
+
+	std::vector<DVector3> normals(numTriangles);
+	std::vector<EdgeKey> keys;
+	keys.reserve(numTriangles * 3);
+	for (MeshIndex t = 0; t < numTriangles; t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		corners[t * 3] = tri.i;
+		corners[t * 3 + 1] = tri.j;
+		corners[t * 3 + 2] = tri.k;
+		//degenerate ones are dropped at the end like the ones the contraction makes
+		deadTriangles[t] = !mesh.isLiveTriangle(tri);
+		if (deadTriangles[t])
+			continue;
+		liveTriangles++;
+
+		for (int k = 0; k < 3; k++)
+		{
+			MeshIndex v = corners[t * 3 + k];
+			nextCorner[t * 3 + k] = firstCorner[v];
+			firstCorner[v] = t * 3 + k;
+
+			EdgeKey key;
+			key.a = std::min(v, corners[t * 3 + (k + 1) % 3]);
+			key.b = std::max(v, corners[t * 3 + (k + 1) % 3]);
+			key.triangle = t;
+			keys.push_back(key);
+		}
+
+		const DVector3 &a = positions[tri.i];
+		DVector3 normal = (positions[tri.j] - a).cross(positions[tri.k] - a);
+		double length = sqrt(normal.dot(normal));
+		if (length == 0)
+			continue;
+		normals[t] = normal * (1 / length);
+		double d = -normals[t].dot(a);
+		quadrics[tri.i].addPlane(normals[t], d, 1);
+		quadrics[tri.j].addPlane(normals[t], d, 1);
+		quadrics[tri.k].addPlane(normals[t], d, 1);
+	}
+
+	//an edge of a single triangle is a border, a plane through it perpendicular to the triangle keeps it in place
+	std::sort(keys.begin(), keys.end());
+	for (size_t i = 0; i < keys.size();)
+	{
+		size_t j = i + 1;
+		while (j < keys.size() && keys[j].a == keys[i].a && keys[j].b == keys[i].b)
+			j++;
+		if (j == i + 1)
+		{
+			Quadric border;
+			border.addBorder(positions[keys[i].a], positions[keys[i].b], normals[keys[i].triangle]);
+			quadrics[keys[i].a].add(border);
+			quadrics[keys[i].b].add(border);
+		}
+		i = j;
+	}
+	//both are the same planes until the triangles change
+	surfaceQuadrics = quadrics;
+
+	heap.reserve(keys.size() / 2);
+	for (size_t i = 0; i < keys.size(); i++)
+		if (i == 0 || keys[i].a != keys[i - 1].a || keys[i].b != keys[i - 1].b)
+			this->push(keys[i].a, keys[i].b);
+}
+
+void FastContraction::push(MeshIndex u, MeshIndex v)
+{
+	Candidate c;
+	Quadric q = surfaceQuadrics[u];
+	q.add(surfaceQuadrics[v]);
+	q.add(quadrics[u], MEMORY_WEIGHT);
+	q.add(quadrics[v], MEMORY_WEIGHT);
+
+	const DVector3 &pu = positions[u], &pv = positions[v];
+	DVector3 middle = (pu + pv) * 0.5;
+	//a point far from the edge means the planes are almost parallel, one of the ends or the middle is safer
+	DVector3 edge = pv - pu;
+	DVector3 position;
+	bool solved = q.minimum(position);
+	if (solved)
+	{
+		DVector3 offset = position - middle;
+		solved = offset.dot(offset) <= 4 * edge.dot(edge);
+	}
+	if (solved)
+		c.cost = q.evaluate(position);
+	else
+	{
+		const DVector3* options[3] = { &middle, &pu, &pv };
+		c.cost = DBL_MAX;
+		for (int i = 0; i < 3; i++)
+		{
+			double cost = q.evaluate(*options[i]);
+			if (cost < c.cost)
+			{
+				c.cost = cost;
+				position = *options[i];
+			}
+		}
+	}
+	c.cost = std::max(c.cost, 0.0);
+	c.position = position.toFloat();
+
+	//the end closest to the new position stays, its normal and uv are the ones kept
+	DVector3 toU = position - pu, toV = position - pv;
+	if (toV.dot(toV) < toU.dot(toU))
+		std::swap(u, v);
+	c.u = u;
+	c.v = v;
+	c.stampU = stamps[u];
+	c.stampV = stamps[v];
+
+	heap.push_back(c);
+	std::push_heap(heap.begin(), heap.end(), MoreCost());
+	TRACE_COUNT("recosts", 1);
+	TRACE_COUNT("queue inserts", 1);
+}
+
+//from the live triangles around v, with the planes of the borders and the anchor like the loaded quadrics
+void FastContraction::updateSurfaceQuadric(MeshIndex v)
+{
+	Quadric &q = surfaceQuadrics[v];
+	q = Quadric();
+	q.addAnchor(positions[v], ANCHOR_WEIGHT);
+
+	this->gatherTriangles(v, trianglesV);
+	for (size_t i = 0; i < trianglesV.size(); i++)
+	{
+		const MeshIndex* tri = &corners[trianglesV[i] * 3];
+		const DVector3 &a = positions[tri[0]];
+		DVector3 normal = (positions[tri[1]] - a).cross(positions[tri[2]] - a);
+		double length = sqrt(normal.dot(normal));
+		if (length > 0)
+			q.addPlane(normal * (1 / length), -normal.dot(a) / length, 1);
+	}
+
+	//an edge to a neighbor only one of the triangles has is a border
+	this->gatherNeighbors(v, v, trianglesV, neighborsV);
+	for (size_t n = 0; n < neighborsV.size(); n++)
+	{
+		const MeshIndex* border = NULL;
+		unsigned int count = 0;
+		for (size_t i = 0; i < trianglesV.size() && count < 2; i++)
+		{
+			const MeshIndex* tri = &corners[trianglesV[i] * 3];
+			if (tri[0] == neighborsV[n] || tri[1] == neighborsV[n] || tri[2] == neighborsV[n])
+			{
+				border = tri;
+				count++;
+			}
+		}
+		if (count == 1)
+		{
+			const DVector3 &a = positions[border[0]];
+			q.addBorder(positions[v], positions[neighborsV[n]], (positions[border[1]] - a).cross(positions[border[2]] - a));
+		}
+	}
+}
+
+bool FastContraction::isStale(const Candidate &c) const
+{
+	return removedVertices[c.u] || removedVertices[c.v] || stamps[c.u] != c.stampU || stamps[c.v] != c.stampV;
+}
+
+//the live triangles around v, the dead ones found on the way are unlinked
+void FastContraction::gatherTriangles(MeshIndex v, std::vector<MeshIndex> &triangles)
+{
+	triangles.clear();
+	MeshIndex previous = NO_CORNER;
+	for (MeshIndex c = firstCorner[v]; c != NO_CORNER; c = nextCorner[c])
+	{
+		if (deadTriangles[c / 3])
+		{
+			if (previous == NO_CORNER)
+				firstCorner[v] = nextCorner[c];
+			else nextCorner[previous] = nextCorner[c];
+			continue;
+		}
+		triangles.push_back(c / 3);
+		previous = c;
+	}
+}
+
+//the vertices sharing a triangle with v, but skip, sorted
+void FastContraction::gatherNeighbors(MeshIndex v, MeshIndex skip, const std::vector<MeshIndex> &triangles, std::vector<MeshIndex> &neighbors) const
+{
+	neighbors.clear();
+	for (size_t i = 0; i < triangles.size(); i++)
+	{
+		for (int k = 0; k < 3; k++)
+		{
+			MeshIndex n = corners[triangles[i] * 3 + k];
+			if (n != v && n != skip)
+				neighbors.push_back(n);
+		}
+	}
+	std::sort(neighbors.begin(), neighbors.end());
+	neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+}
+
+//true if moving the vertex moved to position turns over a triangle that does not also have other
+bool FastContraction::flips(const std::vector<MeshIndex> &triangles, MeshIndex moved, MeshIndex other, const Vector3 &position) const
+{
+	DVector3 to(position);
+	for (size_t i = 0; i < triangles.size(); i++)
+	{
+		const MeshIndex* tri = &corners[triangles[i] * 3];
+		if (tri[0] == other || tri[1] == other || tri[2] == other)
+			continue;
+
+		DVector3 p[3], q[3];
+		for (int k = 0; k < 3; k++)
+		{
+			p[k] = positions[tri[k]];
+			q[k] = tri[k] == moved ? to : p[k];
+		}
+		DVector3 before = (p[1] - p[0]).cross(p[2] - p[0]);
+		DVector3 after = (q[1] - q[0]).cross(q[2] - q[0]);
+		if (before.dot(after) <= 0)
+			return true;
+	}
+	return false;
+}
+
+bool FastContraction::isValid(const Candidate &c)
+{
+	this->gatherTriangles(c.u, trianglesU);
+	this->gatherTriangles(c.v, trianglesV);
+
+	//the surface stays a manifold if the only vertices both ends see are the ones of the triangles on the edge
+	MeshIndex shared = 0;
+	for (size_t i = 0; i < trianglesU.size(); i++)
+	{
+		const MeshIndex* tri = &corners[trianglesU[i] * 3];
+		if (tri[0] == c.v || tri[1] == c.v || tri[2] == c.v)
+			shared++;
+	}
+	if (shared == 0)
+		return false;
+	this->gatherNeighbors(c.u, c.v, trianglesU, neighborsU);
+	this->gatherNeighbors(c.v, c.u, trianglesV, neighborsV);
+	MeshIndex common = 0;
+	for (size_t i = 0, j = 0; i < neighborsU.size() && j < neighborsV.size();)
+	{
+		if (neighborsU[i] < neighborsV[j]) i++;
+		else if (neighborsV[j] < neighborsU[i]) j++;
+		else { common++; i++; j++; }
+	}
+	if (common > shared)
+		return false;
+
+	return !this->flips(trianglesU, c.u, c.v, c.position) && !this->flips(trianglesV, c.v, c.u, c.position);
+}
+
+//isValid gathered the triangles of both ends
+void FastContraction::contract(const Candidate &c)
+{
+	for (size_t i = 0; i < trianglesU.size(); i++)
+	{
+		MeshIndex* tri = &corners[trianglesU[i] * 3];
+		if (tri[0] == c.v || tri[1] == c.v || tri[2] == c.v)
+		{
+			deadTriangles[trianglesU[i]] = 1;
+			liveTriangles--;
+		}
+	}
+
+	//the corners of v go to u, dead ones included, gatherTriangles unlinks those later
+	MeshIndex last = NO_CORNER;
+	for (MeshIndex k = firstCorner[c.v]; k != NO_CORNER; k = nextCorner[k])
+	{
+		corners[k] = c.u;
+		last = k;
+	}
+	if (last != NO_CORNER)
+	{
+		nextCorner[last] = firstCorner[c.u];
+		firstCorner[c.u] = firstCorner[c.v];
+	}
+	firstCorner[c.v] = NO_CORNER;
+
+	positions[c.u] = DVector3(c.position);
+	quadrics[c.u].add(quadrics[c.v]);
+	removedVertices[c.v] = 1;
+	stamps[c.v]++;
+
+	//the triangles around u and its neighbors changed, so did the cost of every edge they have
+	this->gatherTriangles(c.u, trianglesU);
+	this->gatherNeighbors(c.u, c.u, trianglesU, ring);
+	ring.push_back(c.u);
+	std::sort(ring.begin(), ring.end());
+	for (size_t i = 0; i < ring.size(); i++)
+	{
+		this->updateSurfaceQuadric(ring[i]);
+		stamps[ring[i]]++;
+	}
+	for (size_t i = 0; i < ring.size(); i++)
+	{
+		this->gatherTriangles(ring[i], trianglesV);
+		this->gatherNeighbors(ring[i], ring[i], trianglesV, neighborsV);
+		for (size_t j = 0; j < neighborsV.size(); j++)
+		{
+			//the edges between two vertices of the ring once
+			if (neighborsV[j] < ring[i] && std::binary_search(ring.begin(), ring.end(), neighborsV[j]))
+				continue;
+			this->push(ring[i], neighborsV[j]);
+		}
+	}
+}
+
+void FastContraction::sampleMemory()
+{
+	MemoryUsage usage;
+	measureMemory(mesh, usage);
+	usage.bytes[MEMORY_EDGES] += vectorBytes(heap);
+	usage.bytes[MEMORY_ADJACENCY] += vectorBytes(corners) + vectorBytes(firstCorner) + vectorBytes(nextCorner) +
+		vectorBytes(deadTriangles) + vectorBytes(removedVertices) + vectorBytes(stamps);
+	usage.bytes[MEMORY_POSITIONS] += vectorBytes(positions);
+	usage.bytes[MEMORY_QUADRICS] += vectorBytes(quadrics) + vectorBytes(surfaceQuadrics);
+	mesh.memory->sample(usage);
+}
+
+//erases the removed vertices and the dead triangles from the mesh
+void FastContraction::writeBack()
+{
+	MeshIndex numVertices = mesh.indexed_positions.size();
+	std::vector<MeshIndex> remap(numVertices);
+	MeshIndex kept = 0;
+	for (MeshIndex v = 0; v < numVertices; v++)
+	{
+		remap[v] = kept;
+		if (removedVertices[v])
+			continue;
+		mesh.indexed_positions[kept] = positions[v].toFloat();
+		if (mesh.indexed_normalsFinal.size() == numVertices)
+			mesh.indexed_normalsFinal[kept] = mesh.indexed_normalsFinal[v];
+		if (mesh.indexed_uvsFinal.size() == numVertices)
+			mesh.indexed_uvsFinal[kept] = mesh.indexed_uvsFinal[v];
+		kept++;
+	}
+	mesh.indexed_positions.resize(kept);
+	if (mesh.indexed_normalsFinal.size() == numVertices)
+		mesh.indexed_normalsFinal.resize(kept);
+	if (mesh.indexed_uvsFinal.size() == numVertices)
+		mesh.indexed_uvsFinal.resize(kept);
+
+	MeshIndex numTriangles = 0;
+	for (MeshIndex t = 0; t < deadTriangles.size(); t++)
+	{
+		if (deadTriangles[t])
+			continue;
+		const MeshIndex* tri = &corners[t * 3];
+		mesh.triangles[numTriangles++] = Triangle(remap[tri[0]], remap[tri[1]], remap[tri[2]]);
+	}
+	mesh.triangles.erase(mesh.triangles.begin() + numTriangles, mesh.triangles.end());
+
+	mesh.dirtyVertices = true;
+	mesh.dirtyTriangles = true;
+}
+
+MeshIndex FastContraction::run(MeshIndex targetTriangles, double maxError)
+{
+	mesh.collapses = 0;
+	if (mesh.triangles.size() <= targetTriangles)
+		return mesh.triangles.size();
+
+	//the topology of edgeContraction would be stale after this
+	mesh.dropTopology();
+	this->setup();
+	if (mesh.memory)
+		this->sampleMemory();
+
+	MeshIndex initial = liveTriangles, collapses = 0;
+	size_t compactAt = heap.size() * 2;
+	while (liveTriangles > targetTriangles && !heap.empty())
+	{
+		//most entries are stale by now, dropping them keeps the heap in cache
+		if (heap.size() > compactAt)
+		{
+			heap.erase(std::remove_if(heap.begin(), heap.end(), [this](const Candidate &c) { return this->isStale(c); }), heap.end());
+			std::make_heap(heap.begin(), heap.end(), MoreCost());
+			compactAt = heap.size() * 2;
+		}
+
+		Candidate c = heap.front();
+		std::pop_heap(heap.begin(), heap.end(), MoreCost());
+		heap.pop_back();
+		TRACE_COUNT("queue removals", 1);
+		if (this->isStale(c))
+			continue;
+		if (c.cost > maxError)
+		{
+			TRACE_COUNT("rejected collapses", 1);
+			break;
+		}
+		if (!this->isValid(c))
+		{
+			TRACE_COUNT("rejected collapses", 1);
+			continue;
+		}
+
+		this->contract(c);
+		collapses++;
+		TRACE_COUNT("collapses", 1);
+		if (mesh.progress)
+			mesh.progress((float)(initial - liveTriangles) / (initial - targetTriangles));
+		if ((collapses & 255) == 0)
+		{
+			TRACE_SAMPLE();
+			if (mesh.memory)
+				this->sampleMemory();
+		}
+	}
+
+	TRACE_SAMPLE();
+	if (mesh.memory)
+		this->sampleMemory();
+	this->writeBack();
+	mesh.collapses = collapses;
+	return mesh.triangles.size();
+}
+
+MeshIndex fastEdgeContraction(MeshData &mesh, MeshIndex targetTriangles, double maxError)
+{
+	TRACE_SCOPE("collapse");
+	MeshIndex left;
+	{
+		FastContraction contraction(mesh);
+		left = contraction.run(targetTriangles, maxError);
+	}
+	//after the buffers of the contraction are released
+	if (mesh.memory)
+		mesh.memory->endPhase("collapse", mesh);
+	if (mesh.verbose)
+		std::cout << "Finished fastEdgeContraction!" << std::endl;
+	return left;
+}
@@ -1,12 +1,17 @@
 #include "framework.h"
+#include "mathkernels.h"
 
-#include "includes.h"
 #include <cassert>
+#include <cstring> //memset
+#include <iostream>
+#include <algorithm> //swap
 #include <cmath> //for sqrt (square root) function
 #include <math.h> //atan2
 
 
+#ifndef M_PI_2
 #define M_PI_2 1.57079632679489661923
+#endif
 
 
 //Color
@@ -274,34 +279,14 @@ bool Matrix44::getXYZ(float* euler) const
 Matrix44 Matrix44::operator*(const Matrix44& matrix) const
 {
 	Matrix44 ret;
-
-	unsigned int i,j,k;
-	for (i=0;i<4;i++) 	
-	{
-		for (j=0;j<4;j++) 
-		{
-			ret.M[i][j]=0.0;
-			for (k=0;k<4;k++) 
-				ret.M[i][j] += M[i][k] * matrix.M[k][j];
-		}
-	}
-
+	g_mathKernels->multiply(m, matrix.m, ret.m);
 	return ret;
 }
 
 Matrix44 Matrix44::operator+(const Matrix44& matrix) const
 {
 	Matrix44 ret;
-
-	unsigned int i, j;
-	for (i = 0; i<4; i++)
-	{
-		for (j = 0; j<4; j++)
-		{
-			ret.M[i][j] = M[i][j] + matrix.M[i][j];
-		}
-	}
-
+	g_mathKernels->add(m, matrix.m, ret.m);
 	return ret;
 }
 
@@ -425,77 +410,10 @@ void Matrix44::setFrontAndOrthonormalize(Vector3 front)
 	
 }
 
+//Gauss-Jordan with partial pivoting, the matrix is left as it is if it is singular
 bool Matrix44::inverse()
 {
-   unsigned int i, j, k, swap;
-   float t;
-   Matrix44 temp, final;
-   final.setIdentity();
-
-   temp = (*this);
-
-   unsigned int m,n;
-   m = n = 4;
-	
-   for (i = 0; i < m; i++)
-   {
-      // Look for largest element in column
-
-      swap = i;
-      for (j = i + 1; j < m; j++)// m or n
-	  {
-		 if ( fabs(temp.M[j][i]) > fabs( temp.M[swap][i]) )
-            swap = j;
-	  }
-   
-      if (swap != i)
-      {
-         // Swap rows.
-         for (k = 0; k < n; k++)
-         {
-			 std::swap( temp.M[i][k],temp.M[swap][k]);
-			 std::swap( final.M[i][k], final.M[swap][k]);
-         }
-      }
-
-      // No non-zero pivot.  The CMatrix is singular, which shouldn't
-      // happen.  This means the user gave us a bad CMatrix.
-
-
-#define MATRIX_SINGULAR_THRESHOLD 0.00001 //change this if you experience problems with matrices
-
-      if ( fabsf(temp.M[i][i]) <= MATRIX_SINGULAR_THRESHOLD)
-	  {
-		  final.setIdentity();
-         return false;
-	  }
-#undef MATRIX_SINGULAR_THRESHOLD
-
-      t = 1.0f/temp.M[i][i];
-
-      for (k = 0; k < n; k++)//m or n
-      {
-         temp.M[i][k] *= t;
-         final.M[i][k] *= t;
-      }
-
-      for (j = 0; j < m; j++) // m or n
-      {
-         if (j != i)
-         {
-            t = temp.M[j][i];
-            for (k = 0; k < n; k++)//m or n
-            {
-               temp.M[j][k] -= (temp.M[i][k] * t);
-               final.M[j][k] -= (final.M[i][k] * t);
-            }
-         }
-      }
-   }
-
-   *this = final;
-
-   return true;
+	return g_mathKernels->inverse(m, m);
 }
 
 float ComputeSignedAngle( Vector2 a, Vector2 b)
@@ -514,23 +432,6 @@ Vector3 RayPlaneCollision( const Vector3& plane_pos, const Vector3& plane_normal
 	return ray_origin + ray_dir * t;
 }
 
-Triangle::Triangle(unsigned int i, unsigned int j, unsigned int k)
-{
-	this->i = i;
-	this->j = j;
-	this->k = k;
-}
-
-bool Triangle::containsIndex(unsigned int a)
-{
-	return ((this->i == a) || (this->j == a) || (this->k == a));
-}
-
-bool Triangle::containsIndices(unsigned int a, unsigned int b)
-{
-	return this->containsIndex(a) && this->containsIndex(b);
-}
-
 double Vector4::length()
 {
 	return sqrt(x*x + y*y + z*z + w*w);
@@ -558,62 +459,18 @@ float Vector4::dot(const Vector4& v) const
 Vector4 multM4xV4(const Matrix44 &m, const Vector4 &v)
 {
 	Vector4 ret;
-	for (int i = 0; i < 4; i++) 
-	{
-		for (int j = 0; j < 4; j++) 
-		{
-			ret.v[i] += (m.M[i][j] * v.v[j]);
-		}
-	}
+	g_mathKernels->multM4xV4(m.m, v.v, ret.v);
 	return ret;
 }
 
-Vector4 multV4xM4(const Vector4 &v, const Matrix44 &m) 
+Vector4 multV4xM4(const Vector4 &v, const Matrix44 &m)
 {
 	Vector4 ret;
-
-	Vector4 x(m.M[0][0], m.M[1][0], m.M[2][0], m.M[3][0]);
-	Vector4 y(m.M[0][1], m.M[1][1], m.M[2][1], m.M[3][1]);
-	Vector4 z(m.M[0][2], m.M[1][2], m.M[2][2], m.M[3][2]);
-	Vector4 w(m.M[0][3], m.M[1][3], m.M[2][3], m.M[3][3]);
-
-	ret.x = x.dot(v);
-	ret.y = y.dot(v);
-	ret.z = z.dot(v);
-	ret.w = w.dot(v);
+	g_mathKernels->multV4xM4(v.v, m.m, ret.v);
 	return ret;
 }
 
 
-Edge::Edge()
-{
-	a = -1;
-	b = -1;
-	cost = 0;
-}
-
-Edge::Edge(const unsigned &a, const unsigned &b)
-{
-	this->a = a;
-	this->b = b;
-}
-
-bool Edge::operator==(const Edge& p)
-{
-	if (a == p.a && b == p.b)
-		return true;
-	if (a == p.b && b == p.a)
-		return true;
-	return false;
-}
-
-bool Edge::contains(const unsigned int &value) const
-{
-	if (a == value || b == value)
-		return true;
-	else return false;
-}
-
 bool operator==(const Vector3& a, const Vector3& b)
 {
 	if (a.x == b.x && a.y == b.y && a.z == b.z)
@@ -0,0 +1,339 @@
+#include "glbwriter.h"
+#include "meshdata.h"
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+#define GLB_MAGIC 0x46546C67		//"glTF"
+#define GLB_CHUNK_JSON 0x4E4F534A	//"JSON"
+#define GLB_CHUNK_BIN 0x004E4942	//"BIN\0"
+
+#define GLTF_BYTE 5120
+#define GLTF_UNSIGNED_SHORT 5123
+#define GLTF_UNSIGNED_INT 5125
+#define GLTF_FLOAT 5126
+#define GLTF_ARRAY_BUFFER 34962
+#define GLTF_ELEMENT_ARRAY_BUFFER 34963
+
+#define GLB_QUANTIZE_MAX 65535.0f
+
+static void appendf(std::string &out, const char* format, ...)
+{
+	char buffer[512];
+	va_list args;
+	va_start(args, format);
+	int n = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+	if (n > 0)
+		out.append(buffer, std::min(n, (int)sizeof(buffer) - 1));
+}
+
+template<class T> static void append(std::vector<char> &data, const T &value)
+{
+	const char* p = (const char*)&value;
+	data.insert(data.end(), p, p + sizeof(T));
+}
+
+//one attribute of all the levels, stored one after the other in a single buffer view
+struct GlbStream
+{
+	std::vector<char> data;
+	size_t stride; //0 for indices
+};
+
+//the vertices of one level already encoded, to be compared with the next level
+struct GlbVertices
+{
+	std::vector<char> positions, normals, uvs;
+	float min[3], max[3];
+	unsigned int count;
+	int positionAccessor, normalAccessor, uvAccessor;
+};
+
+static int addAccessor(std::string &accessors, int &numAccessors, int view, size_t offset, int componentType, bool normalized, unsigned int count, const char* type)
+{
+	appendf(accessors, "%s{\"bufferView\":%d,\"byteOffset\":%u,\"componentType\":%d,%s\"count\":%u,\"type\":\"%s\"",
+		numAccessors ? "," : "", view, (unsigned int)offset, componentType, normalized ? "\"normalized\":true," : "", count, type);
+	return numAccessors++;
+}
+
+bool writeGLB(const char* filename, const std::vector<const MeshData*> &levels, bool quantize)
+{
+	if (levels.empty())
+		return false;
+
+	//attributes are only written if every level has them
+	bool hasNormals = true, hasUvs = true;
+	for (unsigned int l = 0; l < levels.size(); l++)
+	{
+		size_t numVertices = levels[l]->indexed_positions.size();
+		hasNormals = hasNormals && numVertices && levels[l]->indexed_normalsFinal.size() == numVertices;
+		hasUvs = hasUvs && numVertices && levels[l]->indexed_uvsFinal.size() == numVertices;
+	}
+
+	//bounds of all the levels, the quantization grid is shared so the levels line up
+	std::vector<std::vector<MeshIndex> > remaps(levels.size());
+	Vector3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX), boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	bool uvsInRange = hasUvs;
+	for (unsigned int l = 0; l < levels.size(); l++)
+	{
+		const MeshData &mesh = *levels[l];
+		mesh.remapUsedVertices(remaps[l]);
+		for (size_t v = 0; v < remaps[l].size(); v++)
+		{
+			if (!remaps[l][v])
+				continue;
+			for (int k = 0; k < 3; k++)
+			{
+				boundsMin.v[k] = std::min(boundsMin.v[k], mesh.indexed_positions[v].v[k]);
+				boundsMax.v[k] = std::max(boundsMax.v[k], mesh.indexed_positions[v].v[k]);
+			}
+			if (hasUvs)
+				for (int k = 0; k < 2; k++)
+					uvsInRange = uvsInRange && mesh.indexed_uvsFinal[v].value[k] >= 0 && mesh.indexed_uvsFinal[v].value[k] <= 1;
+		}
+	}
+	float extent = 0;
+	for (int k = 0; k < 3; k++)
+		extent = std::max(extent, boundsMax.v[k] - boundsMin.v[k]);
+	//uniform scale, a different one per axis would bend the normals
+	float scale = extent > 0 ? extent / GLB_QUANTIZE_MAX : 1;
+	bool quantizeUvs = quantize && uvsInRange;
+
+	GlbStream positions, normals, uvs, indices;
+	positions.stride = quantize ? 8 : 12;	//uint16 x3 padded to 4 bytes
+	normals.stride = quantize ? 4 : 12;		//int8 x3 padded
+	uvs.stride = quantizeUvs ? 4 : 8;
+	indices.stride = 0;
+	const int positionView = 0, normalView = 1, uvView = hasNormals ? 2 : 1, indexView = 1 + (hasNormals ? 1 : 0) + (hasUvs ? 1 : 0);
+
+	std::string accessors, meshes, nodes, lods;
+	int numAccessors = 0, numLevels = 0;
+	GlbVertices previous;
+	previous.count = 0;
+
+	for (unsigned int l = 0; l < levels.size(); l++)
+	{
+		const MeshData &mesh = *levels[l];
+		const std::vector<MeshIndex> &remap = remaps[l];
+
+		GlbVertices current;
+		current.count = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			current.min[k] = FLT_MAX;
+			current.max[k] = -FLT_MAX;
+		}
+		for (size_t v = 0; v < remap.size(); v++)
+		{
+			if (!remap[v])
+				continue;
+			current.count++;
+
+			const Vector3 &p = mesh.indexed_positions[v];
+			float stored[3];
+			if (quantize)
+			{
+				uint16_t q[4] = { 0, 0, 0, 0 };
+				for (int k = 0; k < 3; k++)
+				{
+					q[k] = (uint16_t)std::min(GLB_QUANTIZE_MAX, floorf((p.v[k] - boundsMin.v[k]) / scale + 0.5f));
+					stored[k] = q[k];
+				}
+				current.positions.insert(current.positions.end(), (const char*)q, (const char*)(q + 4));
+			}
+			else
+			{
+				for (int k = 0; k < 3; k++)
+					stored[k] = p.v[k];
+				current.positions.insert(current.positions.end(), (const char*)p.v, (const char*)(p.v + 3));
+			}
+			for (int k = 0; k < 3; k++)
+			{
+				current.min[k] = std::min(current.min[k], stored[k]);
+				current.max[k] = std::max(current.max[k], stored[k]);
+			}
+
+			if (hasNormals)
+			{
+				Vector3 n = mesh.indexed_normalsFinal[v];
+				if (quantize)
+				{
+					if (n.length() > 0)
+						n.normalize();
+					int8_t q[4] = { 0, 0, 0, 0 };
+					for (int k = 0; k < 3; k++)
+						q[k] = (int8_t)floorf(clamp(n.v[k], -1.0f, 1.0f) * 127.0f + 0.5f);
+					current.normals.insert(current.normals.end(), (const char*)q, (const char*)(q + 4));
+				}
+				else current.normals.insert(current.normals.end(), (const char*)n.v, (const char*)(n.v + 3));
+			}
+			if (hasUvs)
+			{
+				const Vector2 &uv = mesh.indexed_uvsFinal[v];
+				if (quantizeUvs)
+				{
+					uint16_t q[2] = { (uint16_t)floorf(uv.x * GLB_QUANTIZE_MAX + 0.5f), (uint16_t)floorf(uv.y * GLB_QUANTIZE_MAX + 0.5f) };
+					current.uvs.insert(current.uvs.end(), (const char*)q, (const char*)(q + 2));
+				}
+				else current.uvs.insert(current.uvs.end(), (const char*)uv.value, (const char*)(uv.value + 2));
+			}
+		}
+		if (current.count == 0)
+			continue; //nothing left of this level
+
+		//the same vertices as the previous level, reuse its accessors
+		if (current.count == previous.count && current.positions == previous.positions &&
+			current.normals == previous.normals && current.uvs == previous.uvs)
+		{
+			current.positionAccessor = previous.positionAccessor;
+			current.normalAccessor = previous.normalAccessor;
+			current.uvAccessor = previous.uvAccessor;
+		}
+		else
+		{
+			current.positionAccessor = addAccessor(accessors, numAccessors, positionView, positions.data.size(),
+				quantize ? GLTF_UNSIGNED_SHORT : GLTF_FLOAT, false, current.count, "VEC3");
+			appendf(accessors, ",\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]}",
+				current.min[0], current.min[1], current.min[2], current.max[0], current.max[1], current.max[2]);
+			positions.data.insert(positions.data.end(), current.positions.begin(), current.positions.end());
+
+			current.normalAccessor = current.uvAccessor = -1;
+			if (hasNormals)
+			{
+				current.normalAccessor = addAccessor(accessors, numAccessors, normalView, normals.data.size(),
+					quantize ? GLTF_BYTE : GLTF_FLOAT, quantize, current.count, "VEC3");
+				accessors += "}";
+				normals.data.insert(normals.data.end(), current.normals.begin(), current.normals.end());
+			}
+			if (hasUvs)
+			{
+				current.uvAccessor = addAccessor(accessors, numAccessors, uvView, uvs.data.size(),
+					quantizeUvs ? GLTF_UNSIGNED_SHORT : GLTF_FLOAT, quantizeUvs, current.count, "VEC2");
+				accessors += "}";
+				uvs.data.insert(uvs.data.end(), current.uvs.begin(), current.uvs.end());
+			}
+		}
+
+		//the largest index value is reserved (primitive restart), so uint16 holds up to 65535 vertices
+		bool shortIndices = current.count <= 65535;
+		size_t indexOffset = indices.data.size();
+		unsigned int numIndices = 0;
+		for (size_t t = 0; t < mesh.triangles.size(); t++)
+		{
+			const Triangle &tri = mesh.triangles[t];
+			if (!mesh.isLiveTriangle(tri))
+				continue;
+			const MeshIndex corners[3] = { remap[tri.i] - 1, remap[tri.j] - 1, remap[tri.k] - 1 };
+			for (int k = 0; k < 3; k++)
+			{
+				if (shortIndices)
+					append(indices.data, (uint16_t)corners[k]);
+				else append(indices.data, (uint32_t)corners[k]);
+			}
+			numIndices += 3;
+		}
+		while (indices.data.size() % 4)
+			indices.data.push_back(0);
+		int indexAccessor = addAccessor(accessors, numAccessors, indexView, indexOffset,
+			shortIndices ? GLTF_UNSIGNED_SHORT : GLTF_UNSIGNED_INT, false, numIndices, "SCALAR");
+		accessors += "}";
+
+		appendf(meshes, "%s{\"name\":\"LOD%d\",\"primitives\":[{\"attributes\":{\"POSITION\":%d", numLevels ? "," : "", numLevels, current.positionAccessor);
+		if (hasNormals)
+			appendf(meshes, ",\"NORMAL\":%d", current.normalAccessor);
+		if (hasUvs)
+			appendf(meshes, ",\"TEXCOORD_0\":%d", current.uvAccessor);
+		appendf(meshes, "},\"indices\":%d,\"mode\":4}],\"extras\":{\"triangles\":%u}}", indexAccessor, numIndices / 3);
+
+		appendf(nodes, "%s{\"name\":\"LOD%d\",\"mesh\":%d", numLevels ? "," : "", numLevels, numLevels);
+		if (quantize)
+			appendf(nodes, ",\"matrix\":[%.9g,0,0,0,0,%.9g,0,0,0,0,%.9g,0,%.9g,%.9g,%.9g,1]",
+				scale, scale, scale, boundsMin.x, boundsMin.y, boundsMin.z);
+		nodes += "}";
+		appendf(lods, "%s%d", numLevels ? "," : "", numLevels);
+
+		numLevels++;
+		previous.positions.swap(current.positions);
+		previous.normals.swap(current.normals);
+		previous.uvs.swap(current.uvs);
+		previous.count = current.count;
+		previous.positionAccessor = current.positionAccessor;
+		previous.normalAccessor = current.normalAccessor;
+		previous.uvAccessor = current.uvAccessor;
+	}
+
+	if (numLevels == 0)
+	{
+		std::cerr << "Nothing to write: " << filename << std::endl;
+		return false;
+	}
+
+	//the buffer views go one after the other in the BIN chunk, all the strides are multiples of 4
+	GlbStream* streams[4] = { &positions, hasNormals ? &normals : NULL, hasUvs ? &uvs : NULL, &indices };
+	std::string views;
+	size_t binLength = 0;
+	for (int s = 0; s < 4; s++)
+	{
+		if (streams[s] == NULL)
+			continue;
+		appendf(views, "%s{\"buffer\":0,\"byteOffset\":%u,\"byteLength\":%u", views.empty() ? "" : ",",
+			(unsigned int)binLength, (unsigned int)streams[s]->data.size());
+		if (streams[s]->stride)
+			appendf(views, ",\"byteStride\":%u,\"target\":%d}", (unsigned int)streams[s]->stride, GLTF_ARRAY_BUFFER);
+		else appendf(views, ",\"target\":%d}", GLTF_ELEMENT_ARRAY_BUFFER);
+		binLength += (streams[s]->data.size() + 3) & ~(size_t)3;
+	}
+
+	std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"Surface-Simplification\"}";
+	if (quantize)
+		json += ",\"extensionsUsed\":[\"KHR_mesh_quantization\"],\"extensionsRequired\":[\"KHR_mesh_quantization\"]";
+	json += ",\"scene\":0,\"scenes\":[{\"nodes\":[0],\"extras\":{\"lods\":[" + lods + "]}}]";
+	json += ",\"nodes\":[" + nodes + "],\"meshes\":[" + meshes + "],\"accessors\":[" + accessors + "]";
+	json += ",\"bufferViews\":[" + views + "]";
+	appendf(json, ",\"buffers\":[{\"byteLength\":%u}]}", (unsigned int)binLength);
+	while (json.size() % 4)
+		json += ' ';
+
+	//the whole file length is a 32 bit field, which also keeps every index below 2^32
+	if (12 + 8 + json.size() + 8 + (uint64_t)binLength > UINT32_MAX)
+	{
+		std::cerr << "Too much data for a GLB file: " << filename << std::endl;
+		return false;
+	}
+
+	FILE* f = fopen(filename, "wb");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << filename << std::endl;
+		return false;
+	}
+
+	//written from memory as it is, the machines we build for are little endian like the format
+	uint32_t header[5] = { GLB_MAGIC, 2, (uint32_t)(12 + 8 + json.size() + 8 + binLength), (uint32_t)json.size(), GLB_CHUNK_JSON };
+	uint32_t binHeader[2] = { (uint32_t)binLength, GLB_CHUNK_BIN };
+	static const char padding[4] = { 0, 0, 0, 0 };
+
+	bool ok = fwrite(header, sizeof(header), 1, f) == 1;
+	ok = ok && fwrite(json.data(), 1, json.size(), f) == json.size();
+	ok = ok && fwrite(binHeader, sizeof(binHeader), 1, f) == 1;
+	for (int s = 0; ok && s < 4; s++)
+	{
+		if (streams[s] == NULL)
+			continue;
+		size_t size = streams[s]->data.size();
+		ok = (size == 0 || fwrite(&streams[s]->data[0], 1, size, f) == size) &&
+			fwrite(padding, 1, ((size + 3) & ~(size_t)3) - size, f) == ((size + 3) & ~(size_t)3) - size;
+	}
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		std::cerr << "Error writing file: " << filename << std::endl;
+	return ok;
+}
@@ -0,0 +1,71 @@
+#include "lodselector.h"
+#include "meshdata.h"
+#include <cfloat>
+#include <algorithm>
+
+LodSelector::LodSelector()
+{
+	fullDetailPixels = 1000;
+	hysteresis = 0.1f;
+	level = 0;
+}
+
+void LodSelector::setLevels(const std::vector<float> &ratios)
+{
+	thresholds.resize(ratios.size());
+	for (size_t i = 0; i < ratios.size(); i++)
+		thresholds[i] = fullDetailPixels * sqrtf(std::max(ratios[i], 0.0f));
+	level = 0;
+}
+
+unsigned int LodSelector::select(float screenPixels)
+{
+	//coarser while the size is clearly below the threshold of the next level, finer while it is clearly above ours
+	while (level + 1 < thresholds.size() && screenPixels < thresholds[level + 1] * (1 - hysteresis))
+		level++;
+	while (level > 0 && screenPixels > thresholds[level] * (1 + hysteresis))
+		level--;
+	return level;
+}
+
+void boundingSphere(const MeshData &mesh, Vector3 &center, float &radius)
+{
+	std::vector<MeshIndex> remap;
+	mesh.remapUsedVertices(remap);
+
+	Vector3 boundsMin(FLT_MAX, FLT_MAX, FLT_MAX), boundsMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (size_t v = 0; v < remap.size(); v++)
+	{
+		if (!remap[v])
+			continue;
+		for (int k = 0; k < 3; k++)
+		{
+			boundsMin.v[k] = std::min(boundsMin.v[k], mesh.indexed_positions[v].v[k]);
+			boundsMax.v[k] = std::max(boundsMax.v[k], mesh.indexed_positions[v].v[k]);
+		}
+	}
+	center = Vector3(0, 0, 0);
+	radius = 0;
+	if (boundsMin.x > boundsMax.x)
+		return;
+
+	//centered on the box, the radius reaches the farthest vertex
+	center = (boundsMin + boundsMax) * 0.5f;
+	float radius2 = 0;
+	for (size_t v = 0; v < remap.size(); v++)
+	{
+		if (!remap[v])
+			continue;
+		Vector3 offset = mesh.indexed_positions[v] - center;
+		radius2 = std::max(radius2, offset.dot(offset));
+	}
+	radius = sqrtf(radius2);
+}
+
+float projectedSize(const Vector3 &center, float radius, const Vector3 &eye, float fovDegrees, float viewportHeight)
+{
+	float distance = (float)(center - eye).length();
+	if (distance <= radius)
+		return FLT_MAX; //the camera is inside
+	return radius / (distance * tanf(fovDegrees * 0.5f * (float)DEG2RAD)) * viewportHeight;
+}
@@ -0,0 +1,338 @@
+#include "mathkernels.h"
+
+#include <cmath>
+#include <algorithm> //swap
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define MATHKERNELS_X86
+	#include <immintrin.h>
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define MATH_TARGET_SSE
+		#define MATH_TARGET_AVX
+	#else
+		#include <cpuid.h>
+		#define MATH_TARGET_SSE __attribute__((target("sse2")))
+		#define MATH_TARGET_AVX __attribute__((target("avx")))
+	#endif
+#endif
+
+#define MATRIX_SINGULAR_THRESHOLD 0.00001 //change this if you experience problems with matrices
+
+//****************************
+//scalar, the reference the others must match
+
+static void multiplyScalar(const float* a, const float* b, float* out)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+		{
+			out[i * 4 + j] = 0.0f;
+			for (int k = 0; k < 4; k++)
+				out[i * 4 + j] += a[i * 4 + k] * b[k * 4 + j];
+		}
+	}
+}
+
+static void addScalar(const float* a, const float* b, float* out)
+{
+	for (int i = 0; i < 16; i++)
+		out[i] = a[i] + b[i];
+}
+
+static void multM4xV4Scalar(const float* m, const float* v, float* out)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		out[i] = 0.0f;
+		for (int j = 0; j < 4; j++)
+			out[i] += m[i * 4 + j] * v[j];
+	}
+}
+
+static void multV4xM4Scalar(const float* v, const float* m, float* out)
+{
+	float ret[4];
+	for (int j = 0; j < 4; j++)
+		ret[j] = m[j] * v[0] + m[4 + j] * v[1] + m[8 + j] * v[2] + m[12 + j] * v[3];
+	for (int j = 0; j < 4; j++)
+		out[j] = ret[j];
+}
+
+static bool inverseScalar(const float* in, float* out)
+{
+	float temp[4][4], final[4][4];
+	for (int i = 0; i < 4; i++)
+	{
+		for (int k = 0; k < 4; k++)
+		{
+			temp[i][k] = in[i * 4 + k];
+			final[i][k] = i == k ? 1.0f : 0.0f;
+		}
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		//look for the largest element in the column
+		int swap = i;
+		for (int j = i + 1; j < 4; j++)
+			if (fabs(temp[j][i]) > fabs(temp[swap][i]))
+				swap = j;
+		if (swap != i)
+		{
+			for (int k = 0; k < 4; k++)
+			{
+				std::swap(temp[i][k], temp[swap][k]);
+				std::swap(final[i][k], final[swap][k]);
+			}
+		}
+
+		//no non-zero pivot, the matrix is singular
+		if (fabsf(temp[i][i]) <= MATRIX_SINGULAR_THRESHOLD)
+			return false;
+
+		float t = 1.0f / temp[i][i];
+		for (int k = 0; k < 4; k++)
+		{
+			temp[i][k] *= t;
+			final[i][k] *= t;
+		}
+		for (int j = 0; j < 4; j++)
+		{
+			if (j == i)
+				continue;
+			t = temp[j][i];
+			for (int k = 0; k < 4; k++)
+			{
+				temp[j][k] -= temp[i][k] * t;
+				final[j][k] -= final[i][k] * t;
+			}
+		}
+	}
+
+	for (int i = 0; i < 4; i++)
+		for (int k = 0; k < 4; k++)
+			out[i * 4 + k] = final[i][k];
+	return true;
+}
+
+static const MathKernels s_scalar = { "scalar", multiplyScalar, addScalar, multM4xV4Scalar, multV4xM4Scalar, inverseScalar };
+
+#ifdef MATHKERNELS_X86
+
+//****************************
+//SSE, a row per register
+
+MATH_TARGET_SSE static void multiplySSE(const float* a, const float* b, float* out)
+{
+	__m128 b0 = _mm_loadu_ps(b), b1 = _mm_loadu_ps(b + 4), b2 = _mm_loadu_ps(b + 8), b3 = _mm_loadu_ps(b + 12);
+	for (int i = 0; i < 4; i++)
+	{
+		//from 0 like the scalar sum, so a -0 product ends as +0 there too
+		__m128 row = _mm_add_ps(_mm_setzero_ps(), _mm_mul_ps(_mm_set1_ps(a[i * 4]), b0));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 1]), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 2]), b2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 3]), b3));
+		_mm_storeu_ps(out + i * 4, row);
+	}
+}
+
+MATH_TARGET_SSE static void addSSE(const float* a, const float* b, float* out)
+{
+	for (int i = 0; i < 16; i += 4)
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+}
+
+MATH_TARGET_SSE static void multM4xV4SSE(const float* m, const float* v, float* out)
+{
+	//the columns of m times the components of v, summed in the order of the row dot products
+	__m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	__m128 r = _mm_add_ps(_mm_setzero_ps(), _mm_mul_ps(c0, _mm_set1_ps(v[0])));
+	r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+	r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+	r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(v[3])));
+	_mm_storeu_ps(out, r);
+}
+
+MATH_TARGET_SSE static void multV4xM4SSE(const float* v, const float* m, float* out)
+{
+	__m128 r = _mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(v[0]));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(v[1])));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(v[2])));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3])));
+	_mm_storeu_ps(out, r);
+}
+
+MATH_TARGET_SSE static inline float lane(__m128 v, int i)
+{
+	float values[4];
+	_mm_storeu_ps(values, v);
+	return values[i];
+}
+
+MATH_TARGET_SSE static bool inverseSSE(const float* in, float* out)
+{
+	__m128 temp[4], final[4];
+	for (int i = 0; i < 4; i++)
+	{
+		temp[i] = _mm_loadu_ps(in + i * 4);
+		float identity[4] = { 0, 0, 0, 0 };
+		identity[i] = 1.0f;
+		final[i] = _mm_loadu_ps(identity);
+	}
+
+	for (int i = 0; i < 4; i++)
+	{
+		float column[4];
+		for (int j = i; j < 4; j++)
+			column[j] = lane(temp[j], i);
+		int swap = i;
+		for (int j = i + 1; j < 4; j++)
+			if (fabs(column[j]) > fabs(column[swap]))
+				swap = j;
+		if (swap != i)
+		{
+			std::swap(temp[i], temp[swap]);
+			std::swap(final[i], final[swap]);
+		}
+
+		if (fabsf(column[swap]) <= MATRIX_SINGULAR_THRESHOLD)
+			return false;
+
+		__m128 t = _mm_set1_ps(1.0f / column[swap]);
+		temp[i] = _mm_mul_ps(temp[i], t);
+		final[i] = _mm_mul_ps(final[i], t);
+		for (int j = 0; j < 4; j++)
+		{
+			if (j == i)
+				continue;
+			t = _mm_set1_ps(lane(temp[j], i));
+			temp[j] = _mm_sub_ps(temp[j], _mm_mul_ps(temp[i], t));
+			final[j] = _mm_sub_ps(final[j], _mm_mul_ps(final[i], t));
+		}
+	}
+
+	for (int i = 0; i < 4; i++)
+		_mm_storeu_ps(out + i * 4, final[i]);
+	return true;
+}
+
+static const MathKernels s_sse = { "sse", multiplySSE, addSSE, multM4xV4SSE, multV4xM4SSE, inverseSSE };
+
+//****************************
+//AVX, two rows per register
+
+MATH_TARGET_AVX static inline __m256 pair(__m128 low, __m128 high)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+
+MATH_TARGET_AVX static void multiplyAVX(const float* a, const float* b, float* out)
+{
+	__m256 b0 = _mm256_broadcast_ps((const __m128*)b), b1 = _mm256_broadcast_ps((const __m128*)(b + 4));
+	__m256 b2 = _mm256_broadcast_ps((const __m128*)(b + 8)), b3 = _mm256_broadcast_ps((const __m128*)(b + 12));
+	for (int i = 0; i < 4; i += 2)
+	{
+		const float* r0 = a + i * 4;
+		const float* r1 = r0 + 4;
+		__m256 rows = _mm256_add_ps(_mm256_setzero_ps(), _mm256_mul_ps(pair(_mm_set1_ps(r0[0]), _mm_set1_ps(r1[0])), b0));
+		rows = _mm256_add_ps(rows, _mm256_mul_ps(pair(_mm_set1_ps(r0[1]), _mm_set1_ps(r1[1])), b1));
+		rows = _mm256_add_ps(rows, _mm256_mul_ps(pair(_mm_set1_ps(r0[2]), _mm_set1_ps(r1[2])), b2));
+		rows = _mm256_add_ps(rows, _mm256_mul_ps(pair(_mm_set1_ps(r0[3]), _mm_set1_ps(r1[3])), b3));
+		_mm256_storeu_ps(out + i * 4, rows);
+	}
+}
+
+MATH_TARGET_AVX static void addAVX(const float* a, const float* b, float* out)
+{
+	_mm256_storeu_ps(out, _mm256_add_ps(_mm256_loadu_ps(a), _mm256_loadu_ps(b)));
+	_mm256_storeu_ps(out + 8, _mm256_add_ps(_mm256_loadu_ps(a + 8), _mm256_loadu_ps(b + 8)));
+}
+
+//the vector kernels don't fill a 256 bit register and the inverse is a chain of dependent row operations
+//that measured slower with a row and its inverse row in one register, those stay SSE
+static const MathKernels s_avx = { "avx", multiplyAVX, addAVX, multM4xV4SSE, multV4xM4SSE, inverseSSE };
+
+static void cpuid(int leaf, unsigned int regs[4])
+{
+#ifdef _MSC_VER
+	int r[4];
+	__cpuid(r, leaf);
+	for (int i = 0; i < 4; i++)
+		regs[i] = (unsigned int)r[i];
+#else
+	__cpuid(leaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+static bool cpuHasSSE2()
+{
+	unsigned int regs[4];
+	cpuid(1, regs);
+	return (regs[3] & (1u << 26)) != 0;
+}
+
+//the CPU has it and the OS saves the ymm registers
+static bool cpuHasAVX()
+{
+	unsigned int regs[4];
+	cpuid(1, regs);
+	bool avx = (regs[2] & (1u << 28)) != 0, osxsave = (regs[2] & (1u << 27)) != 0;
+	if (!avx || !osxsave)
+		return false;
+#ifdef _MSC_VER
+	unsigned long long xcr0 = _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	unsigned long long xcr0 = ((unsigned long long)edx << 32) | eax;
+#endif
+	return (xcr0 & 6) == 6;
+}
+
+#endif
+
+const MathKernels& scalarMathKernels()
+{
+	return s_scalar;
+}
+
+const MathKernels* sseMathKernels()
+{
+#ifdef MATHKERNELS_X86
+	static const bool supported = cpuHasSSE2();
+	return supported ? &s_sse : NULL;
+#else
+	return NULL;
+#endif
+}
+
+const MathKernels* avxMathKernels()
+{
+#ifdef MATHKERNELS_X86
+	static const bool supported = cpuHasAVX();
+	return supported ? &s_avx : NULL;
+#else
+	return NULL;
+#endif
+}
+
+const MathKernels& bestMathKernels()
+{
+	if (avxMathKernels())
+		return *avxMathKernels();
+	if (sseMathKernels())
+		return *sseMathKernels();
+	return s_scalar;
+}
+
+//the scalar kernels until the static initializers run, matrices used before then get the same results anyway
+const MathKernels* g_mathKernels = &s_scalar;
+static const bool s_selected = (g_mathKernels = &bestMathKernels(), true);
+
+void setMathKernels(const MathKernels &kernels)
+{
+	g_mathKernels = &kernels;
+}
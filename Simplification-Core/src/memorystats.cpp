@@ -0,0 +1,115 @@
+#include "memorystats.h"
+#include "meshdata.h"
+
+#include <cstdio>
+
+static const char* s_structureNames[MEMORY_STRUCTURES] = { "edges", "vertex_triangles", "vertex_edges", "triangles",
+	"positions", "normals", "uvs", "adjacency", "quadrics", "parse_buffers" };
+
+const char* memoryStructureName(int structure)
+{
+	return s_structureNames[structure];
+}
+
+MemoryUsage::MemoryUsage()
+{
+	for (int i = 0; i < MEMORY_STRUCTURES; i++)
+		bytes[i] = 0;
+}
+
+size_t MemoryUsage::total() const
+{
+	size_t sum = 0;
+	for (int i = 0; i < MEMORY_STRUCTURES; i++)
+		sum += bytes[i];
+	return sum;
+}
+
+void MemoryUsage::max(const MemoryUsage &other)
+{
+	for (int i = 0; i < MEMORY_STRUCTURES; i++)
+		if (other.bytes[i] > bytes[i])
+			bytes[i] = other.bytes[i];
+}
+
+//a tree node is three links and the color next to the value, in both the MSVC and GNU maps
+template<class Map> static size_t mapBytes(const Map &map)
+{
+	size_t bytes = map.size() * (sizeof(typename Map::value_type) + 4 * sizeof(void*));
+	for (typename Map::const_iterator it = map.begin(); it != map.end(); ++it)
+		bytes += vectorBytes(it->second);
+	return bytes;
+}
+
+void measureMemory(const MeshData &mesh, MemoryUsage &usage)
+{
+	usage.bytes[MEMORY_EDGES] = vectorBytes(mesh.edges);
+	usage.bytes[MEMORY_VERTEX_TRIANGLES] = mapBytes(mesh.vertexTriangles);
+	usage.bytes[MEMORY_VERTEX_EDGES] = mapBytes(mesh.vertexEdges);
+	usage.bytes[MEMORY_TRIANGLES] = vectorBytes(mesh.triangles);
+	usage.bytes[MEMORY_POSITIONS] = vectorBytes(mesh.indexed_positions);
+	usage.bytes[MEMORY_NORMALS] = vectorBytes(mesh.indexed_normals) + vectorBytes(mesh.indexed_normalsFinal);
+	usage.bytes[MEMORY_UVS] = vectorBytes(mesh.indexed_uvs) + vectorBytes(mesh.indexed_uvsFinal);
+	usage.bytes[MEMORY_ADJACENCY] = vectorBytes(mesh.adjacencyOffsets) + vectorBytes(mesh.adjacencyTriangles);
+	usage.bytes[MEMORY_QUADRICS] = vectorBytes(mesh.vertexQuadrics);
+}
+
+MemoryTracker::MemoryTracker()
+{
+	peakTotal = 0;
+}
+
+void MemoryTracker::sample(const MemoryUsage &usage)
+{
+	peak.max(usage);
+	if (usage.total() > peakTotal)
+		peakTotal = usage.total();
+}
+
+void MemoryTracker::sample(const MeshData &mesh)
+{
+	MemoryUsage usage;
+	measureMemory(mesh, usage);
+	sample(usage);
+}
+
+void MemoryTracker::endPhase(const char* name, const MeshData &mesh)
+{
+	Phase phase;
+	phase.name = name;
+	measureMemory(mesh, phase.live);
+	sample(phase.live);
+	phase.peak = peak;
+	phase.peakTotal = peakTotal;
+	phases.push_back(phase);
+
+	//the next phase starts from what is alive now
+	peak = phase.live;
+	peakTotal = phase.live.total();
+}
+
+void MemoryTracker::clear()
+{
+	phases.clear();
+	peak = MemoryUsage();
+	peakTotal = 0;
+}
+
+void MemoryTracker::print(std::ostream &out, const char* indent) const
+{
+	const double mb = 1024.0 * 1024.0;
+	char line[256];
+	for (size_t p = 0; p < phases.size(); p++)
+	{
+		const Phase &phase = phases[p];
+		snprintf(line, sizeof(line), "%s%-10s live %9.2f MB  peak %9.2f MB", indent, phase.name.c_str(), phase.live.total() / mb, phase.peakTotal / mb);
+		out << line << std::endl;
+		for (int i = 0; i < MEMORY_STRUCTURES; i++)
+		{
+			if (phase.peak.bytes[i] == 0)
+				continue;
+			snprintf(line, sizeof(line), "%s  %-18s %9.2f MB  peak %9.2f MB", indent, s_structureNames[i], phase.live.bytes[i] / mb, phase.peak.bytes[i] / mb);
+			out << line << std::endl;
+		}
+	}
+}
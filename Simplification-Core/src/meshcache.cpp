@@ -0,0 +1,240 @@
+#include "meshcache.h"
+#include "meshdata.h"
+#include "mappedfile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+	#define stat64_t struct _stat64
+	#define stat64_f _stat64
+#else
+	#define stat64_t struct stat
+	#define stat64_f stat
+#endif
+
+bool getMeshCacheSource(const char* filename, MeshCacheSource &source, bool computeHash)
+{
+	stat64_t st;
+	if (stat64_f(filename, &st) != 0)
+		return false;
+
+	source.size = (uint64_t)st.st_size;
+	source.mtime = (int64_t)st.st_mtime;
+	source.hash = 0;
+
+	if (computeHash)
+	{
+		MappedFile file;
+		if (!file.open(filename))
+			return false;
+		source.hash = hashBytes(file.data(), file.size());
+	}
+	return true;
+}
+
+//64 bit multiply and rotate hash, reads 8 bytes per step so it runs close to memory speed
+uint64_t hashBytes(const void* data, size_t size)
+{
+	const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+	const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+	const unsigned char* p = (const unsigned char*)data;
+	uint64_t h = prime1 ^ (size * prime2);
+
+	size_t words = size / 8;
+	for (size_t i = 0; i < words; i++)
+	{
+		uint64_t w;
+		memcpy(&w, p + i * 8, 8);
+		h ^= w * prime2;
+		h = ((h << 31) | (h >> 33)) * prime1;
+	}
+	for (size_t i = words * 8; i < size; i++)
+	{
+		h ^= p[i] * prime1;
+		h = ((h << 11) | (h >> 53)) * prime2;
+	}
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	return h;
+}
+
+static uint64_t alignOffset(uint64_t offset)
+{
+	return (offset + MESHCACHE_ALIGNMENT - 1) / MESHCACHE_ALIGNMENT * MESHCACHE_ALIGNMENT;
+}
+
+static void addSection(MeshCacheHeader &header, const void** sources, uint32_t type, const void* data, uint32_t elementSize, uint64_t count)
+{
+	if (count == 0)
+		return;
+	MeshCacheSection &section = header.sections[header.numSections];
+	section.type = type;
+	section.elementSize = elementSize;
+	section.count = count;
+	sources[header.numSections] = data;
+	header.numSections++;
+}
+
+bool saveMeshCache(const char* filename, MeshData &mesh, const char* sourceFilename, unsigned int flags)
+{
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESHCACHE_MAGIC, 4);
+	header.version = MESHCACHE_VERSION;
+	if (!getMeshCacheSource(sourceFilename, header.source, true))
+		return false;
+
+	if ((flags & MESHCACHE_ADJACENCY) && mesh.adjacencyOffsets.size() != mesh.indexed_positions.size() + 1)
+		mesh.computeAdjacency();
+	if ((flags & MESHCACHE_QUADRICS) && mesh.vertexQuadrics.size() != mesh.indexed_positions.size())
+		mesh.computeVertexQuadrics();
+
+	const void* sources[MESHCACHE_MAX_SECTIONS];
+	addSection(header, sources, SECTION_POSITIONS, mesh.indexed_positions.data(), sizeof(Vector3), mesh.indexed_positions.size());
+	if (mesh.indexed_normalsFinal.size() == mesh.indexed_positions.size())
+		addSection(header, sources, SECTION_NORMALS, mesh.indexed_normalsFinal.data(), sizeof(Vector3), mesh.indexed_normalsFinal.size());
+	addSection(header, sources, SECTION_UVS, mesh.indexed_uvs.data(), sizeof(Vector2), mesh.indexed_uvs.size());
+	if (mesh.indexed_uvsFinal.size() == mesh.indexed_positions.size())
+		addSection(header, sources, SECTION_VERTEX_UVS, mesh.indexed_uvsFinal.data(), sizeof(Vector2), mesh.indexed_uvsFinal.size());
+	addSection(header, sources, SECTION_TRIANGLES, mesh.triangles.data(), sizeof(Triangle), mesh.triangles.size());
+	if (flags & MESHCACHE_ADJACENCY)
+	{
+		addSection(header, sources, SECTION_ADJACENCY_OFFSETS, mesh.adjacencyOffsets.data(), sizeof(MeshIndex), mesh.adjacencyOffsets.size());
+		addSection(header, sources, SECTION_ADJACENCY_TRIANGLES, mesh.adjacencyTriangles.data(), sizeof(MeshIndex), mesh.adjacencyTriangles.size());
+	}
+	if (flags & MESHCACHE_QUADRICS)
+		addSection(header, sources, SECTION_QUADRICS, mesh.vertexQuadrics.data(), sizeof(Matrix44), mesh.vertexQuadrics.size());
+
+	uint64_t offset = alignOffset(sizeof(MeshCacheHeader));
+	for (uint32_t i = 0; i < header.numSections; i++)
+	{
+		header.sections[i].offset = offset;
+		offset = alignOffset(offset + header.sections[i].count * header.sections[i].elementSize);
+	}
+
+	//write to a temporary name first so a reader never maps a half written cache
+	std::string tempName = std::string(filename) + ".tmp";
+	FILE* f = fopen(tempName.c_str(), "wb");
+	if (f == NULL)
+		return false;
+
+	static const char padding[MESHCACHE_ALIGNMENT] = { 0 };
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	uint64_t written = sizeof(header);
+	for (uint32_t i = 0; ok && i < header.numSections; i++)
+	{
+		const MeshCacheSection &section = header.sections[i];
+		ok = fwrite(padding, 1, (size_t)(section.offset - written), f) == section.offset - written;
+		size_t bytes = (size_t)(section.count * section.elementSize);
+		ok = ok && fwrite(sources[i], 1, bytes, f) == bytes;
+		written = section.offset + bytes;
+	}
+	ok = (fclose(f) == 0) && ok;
+
+	remove(filename);
+	if (!ok || rename(tempName.c_str(), filename) != 0)
+	{
+		remove(tempName.c_str());
+		return false;
+	}
+	return true;
+}
+
+static bool isCacheOf(const MeshCacheHeader &header, const char* sourceFilename)
+{
+	MeshCacheSource source;
+	if (!getMeshCacheSource(sourceFilename, source, false))
+		return false;
+	if (source.size != header.source.size)
+		return false;
+	if (source.mtime == header.source.mtime)
+		return true;
+
+	//touched or copied, still good if the content is the same
+	return getMeshCacheSource(sourceFilename, source, true) && source.hash == header.source.hash;
+}
+
+template<class T> static void copySection(const MappedFile &file, const MeshCacheSection &section, std::vector<T> &out)
+{
+	const T* data = (const T*)(file.data() + section.offset);
+	out.assign(data, data + section.count);
+}
+
+bool loadMeshCache(const char* filename, MeshData &mesh, const char* sourceFilename)
+{
+	MappedFile file;
+	if (!file.open(filename) || file.size() < sizeof(MeshCacheHeader))
+		return false;
+
+	MeshCacheHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, MESHCACHE_MAGIC, 4) != 0 || header.version != MESHCACHE_VERSION || header.numSections > MESHCACHE_MAX_SECTIONS)
+		return false;
+	if (sourceFilename && !isCacheOf(header, sourceFilename))
+		return false;
+
+	//check every section fits in the file and has the element size we expect before touching the mesh
+	for (uint32_t i = 0; i < header.numSections; i++)
+	{
+		const MeshCacheSection &section = header.sections[i];
+		uint32_t expected = 0;
+		switch (section.type)
+		{
+			case SECTION_POSITIONS: case SECTION_NORMALS: expected = sizeof(Vector3); break;
+			case SECTION_UVS: case SECTION_VERTEX_UVS: expected = sizeof(Vector2); break;
+			case SECTION_TRIANGLES: expected = sizeof(Triangle); break;
+			case SECTION_ADJACENCY_OFFSETS: case SECTION_ADJACENCY_TRIANGLES: expected = sizeof(MeshIndex); break;
+			case SECTION_QUADRICS: expected = sizeof(Matrix44); break;
+			default: continue; //unknown sections are skipped
+		}
+		if (section.elementSize != expected || section.offset % MESHCACHE_ALIGNMENT != 0 ||
+			section.offset > file.size() || section.count > (file.size() - section.offset) / expected)
+			return false;
+	}
+
+	mesh.clear();
+	for (uint32_t i = 0; i < header.numSections; i++)
+	{
+		const MeshCacheSection &section = header.sections[i];
+		switch (section.type)
+		{
+			case SECTION_POSITIONS: copySection(file, section, mesh.indexed_positions); break;
+			case SECTION_NORMALS: copySection(file, section, mesh.indexed_normalsFinal); break;
+			case SECTION_UVS: copySection(file, section, mesh.indexed_uvs); break;
+			case SECTION_VERTEX_UVS: copySection(file, section, mesh.indexed_uvsFinal); break;
+			case SECTION_TRIANGLES: copySection(file, section, mesh.triangles); break;
+			case SECTION_ADJACENCY_OFFSETS: copySection(file, section, mesh.adjacencyOffsets); break;
+			case SECTION_ADJACENCY_TRIANGLES: copySection(file, section, mesh.adjacencyTriangles); break;
+			case SECTION_QUADRICS: copySection(file, section, mesh.vertexQuadrics); break;
+		}
+	}
+
+	//a cache that doesn't agree with itself is not used
+	MeshIndex numVertices = mesh.indexed_positions.size();
+	bool valid = (mesh.indexed_normalsFinal.empty() || mesh.indexed_normalsFinal.size() == numVertices) &&
+		(mesh.indexed_uvsFinal.empty() || mesh.indexed_uvsFinal.size() == numVertices);
+	for (size_t t = 0; valid && t < mesh.triangles.size(); t++)
+		valid = mesh.triangles[t].i < numVertices && mesh.triangles[t].j < numVertices && mesh.triangles[t].k < numVertices;
+	if (valid && mesh.adjacencyOffsets.size())
+		valid = mesh.adjacencyOffsets.size() == numVertices + 1 && mesh.adjacencyOffsets[numVertices] == mesh.adjacencyTriangles.size();
+	//never going down also keeps every offset under the last one, buildTopology takes the ranges as they are
+	for (size_t v = 0; valid && v + 1 < mesh.adjacencyOffsets.size(); v++)
+		valid = mesh.adjacencyOffsets[v] <= mesh.adjacencyOffsets[v + 1];
+	for (size_t i = 0; valid && i < mesh.adjacencyTriangles.size(); i++)
+		valid = mesh.adjacencyTriangles[i] < mesh.triangles.size();
+	if (!valid)
+	{
+		mesh.clear();
+		return false;
+	}
+
+	//the renderer only needs one normal per vertex, keep indexed_normals non empty as the flag it is
+	if (mesh.indexed_normalsFinal.size())
+		mesh.indexed_normals = mesh.indexed_normalsFinal;
+	return true;
+}
@@ -0,0 +1,443 @@
+#include "meshcodec.h"
+#include "meshdata.h"
+#include "mappedfile.h"
+#include "trace.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <iostream>
+#include <algorithm>
+
+#define MESHCODEC_NORMALS 1
+#define MESHCODEC_UVS 2
+
+#define MESHCODEC_MAX_VARINT 5	//bytes of a 32 bit varint
+#define MESHCODEC_MORTON_BITS 10
+
+struct MeshCodecHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t flags;
+	uint32_t numVertices;
+	uint32_t numTriangles;
+	uint32_t bits;				//position | normal << 8 | uv << 16
+	float positionMin[3], positionMax[3];
+	float uvMin[2], uvMax[2];
+	uint32_t payloadSize;		//bytes after the header
+};
+
+static inline uint32_t zigzag(int32_t value) { return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31); }
+static inline int32_t unzigzag(uint32_t value) { return (int32_t)(value >> 1) ^ -(int32_t)(value & 1); }
+
+static inline void writeVarint(std::vector<unsigned char> &out, uint32_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((unsigned char)value);
+}
+
+//returns NULL on a truncated or overlong value. The unchecked version is used while there are
+//at least MESHCODEC_MAX_VARINT bytes per value left
+template<bool checked> static inline const unsigned char* readVarint(const unsigned char* p, const unsigned char* end, uint32_t &value)
+{
+	if ((!checked || p < end) && *p < 0x80)
+	{
+		value = *p;
+		return p + 1;
+	}
+	uint32_t result = 0;
+	for (int shift = 0; shift < 7 * MESHCODEC_MAX_VARINT; shift += 7)
+	{
+		if (checked && p >= end)
+			return NULL;
+		unsigned char byte = *p++;
+		result |= (uint32_t)(byte & 0x7F) << shift;
+		if (byte < 0x80)
+		{
+			value = result;
+			return p;
+		}
+	}
+	return NULL;
+}
+
+static inline uint32_t quantize(float value, float min, float max, unsigned int bits)
+{
+	float range = (float)((1u << bits) - 1);
+	float t = max > min ? (value - min) / (max - min) : 0;
+	return (uint32_t)floorf(clamp(t, 0.0f, 1.0f) * range + 0.5f);
+}
+
+//octahedral mapping of a unit vector to two values in [-1, 1]
+static void octEncode(Vector3 n, float &u, float &v)
+{
+	float sum = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+	if (sum == 0)
+	{
+		u = v = 0;
+		return;
+	}
+	n = n * (1.0f / sum);
+	u = n.x;
+	v = n.y;
+	if (n.z < 0)
+	{
+		u = (1 - fabsf(n.y)) * (n.x >= 0 ? 1.0f : -1.0f);
+		v = (1 - fabsf(n.x)) * (n.y >= 0 ? 1.0f : -1.0f);
+	}
+}
+
+static Vector3 octDecode(float u, float v)
+{
+	Vector3 n(u, v, 1 - fabsf(u) - fabsf(v));
+	if (n.z < 0)
+	{
+		n.x = (1 - fabsf(v)) * (u >= 0 ? 1.0f : -1.0f);
+		n.y = (1 - fabsf(u)) * (v >= 0 ? 1.0f : -1.0f);
+	}
+	return n.normalize();
+}
+
+static uint32_t spreadBits(uint32_t x)
+{
+	x &= 0x3FF;
+	x = (x | (x << 16)) & 0x030000FF;
+	x = (x | (x << 8)) & 0x0300F00F;
+	x = (x | (x << 4)) & 0x030C30C3;
+	x = (x | (x << 2)) & 0x09249249;
+	return x;
+}
+
+static uint32_t morton(const uint32_t* q, unsigned int bits)
+{
+	uint32_t c[3];
+	for (int k = 0; k < 3; k++)
+		c[k] = bits > MESHCODEC_MORTON_BITS ? q[k] >> (bits - MESHCODEC_MORTON_BITS) : q[k] << (MESHCODEC_MORTON_BITS - bits);
+	return spreadBits(c[0]) | (spreadBits(c[1]) << 1) | (spreadBits(c[2]) << 2);
+}
+
+struct LessTriangle
+{
+	bool operator()(const Triangle &a, const Triangle &b) const
+	{
+		if (a.i != b.i) return a.i < b.i;
+		if (a.j != b.j) return a.j < b.j;
+		return a.k < b.k;
+	}
+};
+
+size_t rawMeshSize(const MeshData &mesh)
+{
+	std::vector<MeshIndex> remap;
+	size_t numVertices = mesh.remapUsedVertices(remap);
+	size_t numTriangles = 0;
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+		if (mesh.isLiveTriangle(mesh.triangles[t]))
+			numTriangles++;
+	size_t vertexSize = sizeof(Vector3);
+	if (mesh.indexed_normalsFinal.size() == mesh.indexed_positions.size())
+		vertexSize += sizeof(Vector3);
+	if (mesh.indexed_uvsFinal.size() == mesh.indexed_positions.size())
+		vertexSize += sizeof(Vector2);
+	return numVertices * vertexSize + numTriangles * sizeof(Triangle);
+}
+
+bool encodeMesh(const MeshData &mesh, const MeshCodecOptions &options, std::vector<unsigned char> &out)
+{
+	TRACE_SCOPE("encode");
+	if (options.positionBits < 1 || options.positionBits > 24 || options.normalBits < 1 || options.normalBits > 16 ||
+		options.uvBits < 1 || options.uvBits > 24)
+		return false;
+
+	std::vector<MeshIndex> remap;
+	MeshIndex numVertices = mesh.remapUsedVertices(remap);
+	//the container counts and indices are 32 bit whatever MeshIndex is
+	if ((uint64_t)mesh.indexed_positions.size() >= UINT32_MAX || (uint64_t)mesh.triangles.size() >= UINT32_MAX)
+		return false;
+	std::vector<unsigned int> used;
+	for (unsigned int v = 0; v < mesh.indexed_positions.size(); v++)
+		used.push_back(v);
+	used.erase(std::remove_if(used.begin(), used.end(), [&](unsigned int v) { return remap[v] == 0; }), used.end());
+
+	bool hasNormals = numVertices && mesh.indexed_normalsFinal.size() == mesh.indexed_positions.size();
+	bool hasUvs = numVertices && mesh.indexed_uvsFinal.size() == mesh.indexed_positions.size();
+
+	MeshCodecHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESHCODEC_MAGIC, 4);
+	header.version = MESHCODEC_VERSION;
+	header.flags = (hasNormals ? MESHCODEC_NORMALS : 0) | (hasUvs ? MESHCODEC_UVS : 0);
+	header.numVertices = (uint32_t)numVertices;
+	header.bits = options.positionBits | (options.normalBits << 8) | (options.uvBits << 16);
+	for (int k = 0; k < 3; k++)
+	{
+		header.positionMin[k] = numVertices ? FLT_MAX : 0;
+		header.positionMax[k] = numVertices ? -FLT_MAX : 0;
+	}
+	for (int k = 0; k < 2; k++)
+	{
+		header.uvMin[k] = hasUvs ? FLT_MAX : 0;
+		header.uvMax[k] = hasUvs ? -FLT_MAX : 0;
+	}
+	for (unsigned int i = 0; i < used.size(); i++)
+	{
+		const Vector3 &p = mesh.indexed_positions[used[i]];
+		for (int k = 0; k < 3; k++)
+		{
+			header.positionMin[k] = std::min(header.positionMin[k], p.v[k]);
+			header.positionMax[k] = std::max(header.positionMax[k], p.v[k]);
+		}
+		if (hasUvs)
+		{
+			const Vector2 &uv = mesh.indexed_uvsFinal[used[i]];
+			for (int k = 0; k < 2; k++)
+			{
+				header.uvMin[k] = std::min(header.uvMin[k], uv.value[k]);
+				header.uvMax[k] = std::max(header.uvMax[k], uv.value[k]);
+			}
+		}
+	}
+
+	//quantized attributes, up to 7 values per vertex
+	const unsigned int stride = 3 + (hasNormals ? 2 : 0) + (hasUvs ? 2 : 0);
+	std::vector<uint32_t> quantized(used.size() * stride);
+	for (unsigned int i = 0; i < used.size(); i++)
+	{
+		uint32_t* q = &quantized[i * stride];
+		const Vector3 &p = mesh.indexed_positions[used[i]];
+		for (int k = 0; k < 3; k++)
+			*q++ = quantize(p.v[k], header.positionMin[k], header.positionMax[k], options.positionBits);
+		if (hasNormals)
+		{
+			float u, v;
+			octEncode(mesh.indexed_normalsFinal[used[i]], u, v);
+			*q++ = quantize(u, -1, 1, options.normalBits);
+			*q++ = quantize(v, -1, 1, options.normalBits);
+		}
+		if (hasUvs)
+		{
+			const Vector2 &uv = mesh.indexed_uvsFinal[used[i]];
+			for (int k = 0; k < 2; k++)
+				*q++ = quantize(uv.value[k], header.uvMin[k], header.uvMax[k], options.uvBits);
+		}
+	}
+
+	//triangles along a Morton curve of their centroids (remap[v] - 1 is the position of v in used)
+	std::vector<std::pair<uint32_t, unsigned int> > order;
+	for (unsigned int t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		if (!mesh.isLiveTriangle(tri))
+			continue;
+		const uint32_t* qa = &quantized[(remap[tri.i] - 1) * stride];
+		const uint32_t* qb = &quantized[(remap[tri.j] - 1) * stride];
+		const uint32_t* qc = &quantized[(remap[tri.k] - 1) * stride];
+		uint32_t centroid[3];
+		for (int k = 0; k < 3; k++)
+			centroid[k] = (uint32_t)(((uint64_t)qa[k] + qb[k] + qc[k]) / 3);
+		order.push_back(std::make_pair(morton(centroid, options.positionBits), t));
+	}
+	std::sort(order.begin(), order.end());
+
+	//vertices numbered in order of first use, then every triangle starting at its smallest vertex (keeping the winding)
+	std::vector<unsigned int> newIndex(used.size(), 0xFFFFFFFFu);
+	std::vector<unsigned int> vertexOrder;
+	vertexOrder.reserve(used.size());
+	std::vector<Triangle> triangles;
+	triangles.reserve(order.size());
+	for (unsigned int o = 0; o < order.size(); o++)
+	{
+		const Triangle &tri = mesh.triangles[order[o].second];
+		unsigned int corners[3] = { (unsigned int)remap[tri.i] - 1, (unsigned int)remap[tri.j] - 1, (unsigned int)remap[tri.k] - 1 };
+		for (int k = 0; k < 3; k++)
+		{
+			if (newIndex[corners[k]] == 0xFFFFFFFFu)
+			{
+				newIndex[corners[k]] = vertexOrder.size();
+				vertexOrder.push_back(corners[k]);
+			}
+			corners[k] = newIndex[corners[k]];
+		}
+		unsigned int a = corners[0], b = corners[1], c = corners[2];
+		if (b < a && b < c)
+			triangles.push_back(Triangle(b, c, a));
+		else if (c < a && c < b)
+			triangles.push_back(Triangle(c, a, b));
+		else triangles.push_back(Triangle(a, b, c));
+	}
+	std::sort(triangles.begin(), triangles.end(), LessTriangle());
+	header.numTriangles = (uint32_t)triangles.size();
+
+	std::vector<unsigned char> payload;
+	payload.reserve(used.size() * stride * 2 + triangles.size() * 4);
+	uint32_t previous[7] = { 0, 0, 0, 0, 0, 0, 0 };
+	for (unsigned int k = 0; k < vertexOrder.size(); k++)
+	{
+		const uint32_t* q = &quantized[vertexOrder[k] * stride];
+		for (unsigned int c = 0; c < stride; c++)
+		{
+			writeVarint(payload, zigzag((int32_t)(q[c] - previous[c])));
+			previous[c] = q[c];
+		}
+	}
+	//sorted, so a only grows, and b and c are bigger than a
+	unsigned int previousA = 0;
+	for (unsigned int t = 0; t < triangles.size(); t++)
+	{
+		writeVarint(payload, (uint32_t)(triangles[t].i - previousA));
+		writeVarint(payload, (uint32_t)(triangles[t].j - triangles[t].i));
+		writeVarint(payload, (uint32_t)(triangles[t].k - triangles[t].i));
+		previousA = (unsigned int)triangles[t].i;
+	}
+	if (payload.size() > UINT32_MAX)
+		return false;
+	header.payloadSize = (uint32_t)payload.size();
+
+	out.resize(sizeof(header) + payload.size());
+	memcpy(&out[0], &header, sizeof(header));
+	if (payload.size())
+		memcpy(&out[sizeof(header)], &payload[0], payload.size());
+	return true;
+}
+
+//one vertex of stride values, checked near the end of the data
+template<bool checked> static inline const unsigned char* readVertex(const unsigned char* p, const unsigned char* end, unsigned int stride, uint32_t* values)
+{
+	for (unsigned int c = 0; c < stride && p; c++)
+	{
+		uint32_t delta = 0; //not set when the data is cut short
+		p = readVarint<checked>(p, end, delta);
+		values[c] += (uint32_t)unzigzag(delta);
+	}
+	return p;
+}
+
+bool decodeMesh(const unsigned char* data, size_t size, MeshData &mesh)
+{
+	TRACE_SCOPE("decode");
+	MeshCodecHeader header;
+	if (size < sizeof(header))
+		return false;
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, MESHCODEC_MAGIC, 4) != 0 || header.version != MESHCODEC_VERSION || header.payloadSize != size - sizeof(header))
+		return false;
+
+	unsigned int positionBits = header.bits & 0xFF, normalBits = (header.bits >> 8) & 0xFF, uvBits = (header.bits >> 16) & 0xFF;
+	bool hasNormals = (header.flags & MESHCODEC_NORMALS) != 0, hasUvs = (header.flags & MESHCODEC_UVS) != 0;
+	const unsigned int stride = 3 + (hasNormals ? 2 : 0) + (hasUvs ? 2 : 0);
+	//every value takes at least one byte, don't trust counts the data can't hold
+	if (positionBits < 1 || positionBits > 24 || normalBits < 1 || normalBits > 16 || uvBits < 1 || uvBits > 24 ||
+		(uint64_t)header.numVertices * stride + (uint64_t)header.numTriangles * 3 > header.payloadSize)
+		return false;
+
+	mesh.clear();
+	mesh.indexed_positions.resize(header.numVertices);
+	if (hasNormals)
+		mesh.indexed_normalsFinal.resize(header.numVertices);
+	if (hasUvs)
+		mesh.indexed_uvsFinal.resize(header.numVertices);
+	mesh.triangles.reserve(header.numTriangles);
+
+	float positionScale[3], uvScale[2];
+	for (int k = 0; k < 3; k++)
+		positionScale[k] = (header.positionMax[k] - header.positionMin[k]) / (float)((1u << positionBits) - 1);
+	for (int k = 0; k < 2; k++)
+		uvScale[k] = (header.uvMax[k] - header.uvMin[k]) / (float)((1u << uvBits) - 1);
+	const float normalScale = 2.0f / (float)((1u << normalBits) - 1);
+
+	const unsigned char* p = data + sizeof(header);
+	const unsigned char* end = data + size;
+	uint32_t values[7] = { 0, 0, 0, 0, 0, 0, 0 };
+	for (unsigned int v = 0; v < header.numVertices; v++)
+	{
+		if ((size_t)(end - p) >= stride * MESHCODEC_MAX_VARINT)
+			p = readVertex<false>(p, end, stride, values);
+		else p = readVertex<true>(p, end, stride, values);
+		if (p == NULL)
+			break;
+
+		Vector3 &position = mesh.indexed_positions[v];
+		for (int k = 0; k < 3; k++)
+			position.v[k] = header.positionMin[k] + values[k] * positionScale[k];
+		unsigned int c = 3;
+		if (hasNormals)
+		{
+			mesh.indexed_normalsFinal[v] = octDecode(values[c] * normalScale - 1, values[c + 1] * normalScale - 1);
+			c += 2;
+		}
+		if (hasUvs)
+			for (int k = 0; k < 2; k++)
+				mesh.indexed_uvsFinal[v].value[k] = header.uvMin[k] + values[c + k] * uvScale[k];
+	}
+
+	uint32_t a = 0;
+	for (unsigned int t = 0; t < header.numTriangles && p; t++)
+	{
+		uint32_t da, db, dc;
+		if ((size_t)(end - p) >= 3 * MESHCODEC_MAX_VARINT)
+		{
+			p = readVarint<false>(p, end, da);
+			p = p ? readVarint<false>(p, end, db) : NULL;
+			p = p ? readVarint<false>(p, end, dc) : NULL;
+		}
+		else
+		{
+			p = readVarint<true>(p, end, da);
+			p = p ? readVarint<true>(p, end, db) : NULL;
+			p = p ? readVarint<true>(p, end, dc) : NULL;
+		}
+		if (p == NULL)
+			break;
+		a += da;
+		if ((uint64_t)a + db >= header.numVertices || (uint64_t)a + dc >= header.numVertices)
+		{
+			p = NULL;
+			break;
+		}
+		mesh.triangles.push_back(Triangle(a, a + db, a + dc));
+	}
+
+	if (p != end)
+	{
+		mesh.clear();
+		return false;
+	}
+
+	//same as the other loaders, the per vertex arrays double as the source ones
+	mesh.indexed_normals = mesh.indexed_normalsFinal;
+	mesh.indexed_uvs = mesh.indexed_uvsFinal;
+	return true;
+}
+
+bool saveCompressedMesh(const char* filename, const MeshData &mesh, const MeshCodecOptions &options)
+{
+	std::vector<unsigned char> data;
+	if (!encodeMesh(mesh, options, data))
+		return false;
+
+	FILE* f = fopen(filename, "wb");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << filename << std::endl;
+		return false;
+	}
+	bool ok = fwrite(&data[0], 1, data.size(), f) == data.size();
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		std::cerr << "Error writing file: " << filename << std::endl;
+	return ok;
+}
+
+bool loadCompressedMesh(const char* filename, MeshData &mesh)
+{
+	MappedFile file;
+	if (!file.open(filename))
+		return false;
+	return decodeMesh((const unsigned char*)file.data(), file.size(), mesh);
+}
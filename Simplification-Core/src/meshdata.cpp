@@ -0,0 +1,798 @@
+#include "meshdata.h"
+#include "mappedfile.h"
+#include "objparser.h"
+#include "meshcache.h"
+#include "objwriter.h"
+#include "plyfile.h"
+#include "stlfile.h"
+#include "meshcodec.h"
+#include "trace.h"
+#include "memorystats.h"
+#include "fastcontraction.h"
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <iostream>
+#include <algorithm>
+#include <string>
+
+
+MeshData::MeshData()
+{
+	verbose = true;
+	loadThreads = 0;
+	memory = NULL;
+	collapses = 0;
+	dirtyVertices = dirtyTriangles = true;
+}
+
+//the arrays of the mesh and the buffers a loader still holds
+static void sampleParse(const MeshData &mesh, size_t parseBytes)
+{
+	MemoryUsage usage;
+	measureMemory(mesh, usage);
+	usage.bytes[MEMORY_PARSE_BUFFERS] = parseBytes;
+	mesh.memory->sample(usage);
+}
+
+void MeshData::clear()
+{
+	vertexTriangles.clear();
+	vertexEdges.clear();
+	edges.clear();
+	indexed_positions.clear();
+	indexed_normals.clear();
+	indexed_normalsFinal.clear();
+	indexed_uvsFinal.clear();
+	indexed_uvs.clear();
+	triangles.clear();
+	dropPrecomputed();
+	dirtyVertices = true;
+	dirtyTriangles = true;
+}
+
+void MeshData::dropPrecomputed()
+{
+	//released, not only cleared, they are as big as the mesh and not needed again
+	std::vector<MeshIndex>().swap(adjacencyOffsets);
+	std::vector<MeshIndex>().swap(adjacencyTriangles);
+	std::vector<Matrix44>().swap(vertexQuadrics);
+}
+
+void MeshData::dropTopology()
+{
+	vertexTriangles.clear();
+	vertexEdges.clear();
+	std::vector<Edge>().swap(edges);
+	dropPrecomputed();
+}
+
+void MeshData::swap(MeshData &other)
+{
+	vertexTriangles.swap(other.vertexTriangles);
+	vertexEdges.swap(other.vertexEdges);
+	edges.swap(other.edges);
+	indexed_positions.swap(other.indexed_positions);
+	indexed_normals.swap(other.indexed_normals);
+	indexed_normalsFinal.swap(other.indexed_normalsFinal);
+	indexed_uvs.swap(other.indexed_uvs);
+	indexed_uvsFinal.swap(other.indexed_uvsFinal);
+	triangles.swap(other.triangles);
+	adjacencyOffsets.swap(other.adjacencyOffsets);
+	adjacencyTriangles.swap(other.adjacencyTriangles);
+	vertexQuadrics.swap(other.vertexQuadrics);
+	dirtyVertices = true;
+	dirtyTriangles = true;
+	other.dirtyVertices = true;
+	other.dirtyTriangles = true;
+}
+
+bool MeshData::loadOBJ(const char* filename)
+{
+	if (verbose)
+		std::cout << "Loading Mesh: " << filename << std::endl;
+
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		std::cerr << "File not found: " << filename << std::endl;
+		return false;
+	}
+
+	this->clear();
+
+	ObjData obj;
+	parseOBJParallel(file.data(), file.end(), obj, loadThreads);
+	file.close();
+	if (memory)
+		sampleParse(*this, vectorBytes(obj.positions) + vectorBytes(obj.uvs) + vectorBytes(obj.normals) + vectorBytes(obj.corners) + vectorBytes(obj.relative));
+
+	indexed_positions.swap(obj.positions);
+	indexed_uvs.swap(obj.uvs);
+	indexed_normals.swap(obj.normals);
+
+	//normals and uvs are stored per position, the last corner referencing a position wins
+	if (indexed_normals.size())
+		indexed_normalsFinal.assign(indexed_positions.size(), Vector3(0, 0, 0));
+	if (indexed_uvs.size())
+		indexed_uvsFinal.assign(indexed_positions.size(), Vector2(0, 0));
+
+	if (!fitsMeshIndex(indexed_positions.size()) || !fitsMeshIndex(obj.corners.size() / 3))
+	{
+		std::cerr << "Too many vertices or triangles for " << sizeof(MeshIndex) * 8 << " bit indices: " << filename << std::endl;
+		this->clear();
+		return false;
+	}
+
+	ObjIndex numPositions = (ObjIndex)indexed_positions.size();
+	ObjIndex numNormals = (ObjIndex)indexed_normals.size();
+	ObjIndex numUvs = (ObjIndex)indexed_uvs.size();
+	size_t skipped = 0;
+
+	triangles.reserve(obj.corners.size() / 3);
+	for (size_t c = 0; c + 2 < obj.corners.size(); c += 3)
+	{
+		const ObjCorner* corner = &obj.corners[c];
+		if (corner[0].v < 0 || corner[0].v >= numPositions ||
+			corner[1].v < 0 || corner[1].v >= numPositions ||
+			corner[2].v < 0 || corner[2].v >= numPositions)
+		{
+			skipped++;
+			continue;
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			if (corner[k].vn >= 0 && corner[k].vn < numNormals)
+				indexed_normalsFinal[corner[k].v] = indexed_normals[corner[k].vn];
+			if (corner[k].vt >= 0 && corner[k].vt < numUvs)
+				indexed_uvsFinal[corner[k].v] = indexed_uvs[corner[k].vt];
+		}
+
+		triangles.push_back(Triangle((MeshIndex)corner[0].v, (MeshIndex)corner[1].v, (MeshIndex)corner[2].v));
+	}
+
+	if (skipped)
+		std::cerr << "Skipped " << skipped << " triangles with invalid indices in " << filename << std::endl;
+
+	if (memory)
+	{
+		sampleParse(*this, vectorBytes(obj.corners) + vectorBytes(obj.relative));
+		memory->endPhase("parse", *this);
+	}
+	this->buildTopology();
+
+	return true;
+}
+
+//case insensitive, ext with the dot
+static bool hasExtension(const char* filename, const char* ext)
+{
+	size_t length = strlen(filename), extLength = strlen(ext);
+	if (length < extLength)
+		return false;
+	for (size_t i = 0; i < extLength; i++)
+		if (tolower(filename[length - extLength + i]) != ext[i])
+			return false;
+	return true;
+}
+
+bool MeshData::load(const char* filename)
+{
+	TRACE_SCOPE("load");
+	if (hasExtension(filename, ".ply"))
+		return this->loadPLY(filename);
+	if (hasExtension(filename, ".stl"))
+		return this->loadSTL(filename);
+	if (hasExtension(filename, ".ssmz"))
+		return this->loadCompressed(filename);
+	return this->loadOBJ(filename);
+}
+
+bool MeshData::save(const char* filename) const
+{
+	TRACE_SCOPE("save");
+	if (hasExtension(filename, ".ply"))
+		return this->savePLY(filename);
+	if (hasExtension(filename, ".stl"))
+		return this->saveSTL(filename);
+	if (hasExtension(filename, ".ssmz"))
+		return this->saveCompressed(filename);
+	return this->saveOBJ(filename);
+}
+
+bool MeshData::loadPLY(const char* filename)
+{
+	if (verbose)
+		std::cout << "Loading Mesh: " << filename << std::endl;
+
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		std::cerr << "File not found: " << filename << std::endl;
+		return false;
+	}
+
+	this->clear();
+
+	PlyData ply;
+	if (!parsePLY(file.data(), file.end(), ply))
+	{
+		std::cerr << "Invalid PLY file: " << filename << std::endl;
+		return false;
+	}
+	file.close();
+	if (memory)
+		sampleParse(*this, vectorBytes(ply.positions) + vectorBytes(ply.normals) + vectorBytes(ply.uvs) + vectorBytes(ply.triangles));
+
+	//PLY attributes are already per vertex
+	indexed_positions.swap(ply.positions);
+	indexed_normals.swap(ply.normals);
+	indexed_uvs.swap(ply.uvs);
+	indexed_normalsFinal = indexed_normals;
+	indexed_uvsFinal = indexed_uvs;
+	triangles.swap(ply.triangles);
+
+	if (ply.skipped)
+		std::cerr << "Skipped " << ply.skipped << " triangles with invalid indices in " << filename << std::endl;
+
+	if (memory)
+		memory->endPhase("parse", *this);
+	this->buildTopology();
+
+	return true;
+}
+
+bool MeshData::loadSTL(const char* filename)
+{
+	if (verbose)
+		std::cout << "Loading Mesh: " << filename << std::endl;
+
+	MappedFile file;
+	if (!file.open(filename))
+	{
+		std::cerr << "File not found: " << filename << std::endl;
+		return false;
+	}
+
+	this->clear();
+
+	//welded while reading, the positions are unique so no two vertices share one
+	StlData stl;
+	if (!parseSTL(file.data(), file.end(), stl))
+	{
+		std::cerr << "Invalid STL file: " << filename << std::endl;
+		return false;
+	}
+	file.close();
+	if (memory)
+		sampleParse(*this, vectorBytes(stl.positions) + vectorBytes(stl.triangles));
+
+	indexed_positions.swap(stl.positions);
+	triangles.swap(stl.triangles);
+
+	if (stl.skipped && verbose)
+		std::cout << "Skipped " << stl.skipped << " degenerate triangles in " << filename << std::endl;
+
+	if (memory)
+		memory->endPhase("parse", *this);
+	this->buildTopology();
+
+	return true;
+}
+
+bool MeshData::loadCompressed(const char* filename)
+{
+	if (verbose)
+		std::cout << "Loading Mesh: " << filename << std::endl;
+
+	if (!loadCompressedMesh(filename, *this))
+	{
+		std::cerr << "Invalid compressed mesh: " << filename << std::endl;
+		return false;
+	}
+
+	if (memory)
+		memory->endPhase("parse", *this);
+	this->buildTopology();
+
+	return true;
+}
+
+bool MeshData::loadCached(const char* filename)
+{
+	std::string cacheName = std::string(filename) + ".cache";
+
+	if (loadMeshCache(cacheName.c_str(), *this, filename))
+	{
+		if (verbose)
+			std::cout << "Loaded Mesh from cache: " << cacheName << std::endl;
+		if (memory)
+			memory->endPhase("parse", *this);
+		this->buildTopology();
+		return true;
+	}
+
+	if (!this->load(filename))
+		return false;
+
+	if (!saveMeshCache(cacheName.c_str(), *this, filename, MESHCACHE_ADJACENCY | MESHCACHE_QUADRICS))
+		std::cerr << "Can't write mesh cache: " << cacheName << std::endl;
+	return true;
+}
+
+void MeshData::buildTopology()
+{
+	TRACE_SCOPE("setup");
+	if (adjacencyOffsets.size() != indexed_positions.size() + 1)
+		this->computeAdjacency();
+
+	//the contraction works on positions, vertices sharing one get their triangles merged
+	for (MeshIndex v = 0; v < indexed_positions.size(); v++)
+	{
+		if (adjacencyOffsets[v] == adjacencyOffsets[v + 1])
+			continue;
+		vector<MeshIndex> &list = this->vertexTriangles[this->indexed_positions[v]];
+		list.insert(list.end(), adjacencyTriangles.begin() + adjacencyOffsets[v], adjacencyTriangles.begin() + adjacencyOffsets[v + 1]);
+	}
+
+	if (vertexQuadrics.size() != indexed_positions.size())
+		this->computeVertexQuadrics();
+
+	edges.reserve(triangles.size() * 3);
+	for (MeshIndex triIndex = 0; triIndex < this->triangles.size(); triIndex++)
+	{
+		Triangle tri = this->triangles[triIndex];
+		const MeshIndex corners[4] = { tri.i, tri.j, tri.k, tri.i };
+
+		for (int k = 0; k < 3; k++)
+		{
+			Edge e(corners[k], corners[k + 1]);
+			e.triangleIndex = triIndex;
+			this->computeCost(&e, vertexQuadrics[e.a] + vertexQuadrics[e.b]);
+			this->insertEdge(e);
+		}
+	}
+
+	if (memory)
+		memory->endPhase("setup", *this);
+}
+
+void MeshData::computeAdjacency()
+{
+	TRACE_SCOPE("adjacency");
+	MeshIndex numVertices = indexed_positions.size();
+	adjacencyOffsets.assign(numVertices + 1, 0);
+
+	for (MeshIndex t = 0; t < triangles.size(); t++)
+	{
+		adjacencyOffsets[triangles[t].i + 1]++;
+		adjacencyOffsets[triangles[t].j + 1]++;
+		adjacencyOffsets[triangles[t].k + 1]++;
+	}
+	for (MeshIndex v = 0; v < numVertices; v++)
+		adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+
+	adjacencyTriangles.resize(adjacencyOffsets[numVertices]);
+	vector<MeshIndex> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (MeshIndex t = 0; t < triangles.size(); t++)
+	{
+		adjacencyTriangles[fill[triangles[t].i]++] = t;
+		adjacencyTriangles[fill[triangles[t].j]++] = t;
+		adjacencyTriangles[fill[triangles[t].k]++] = t;
+	}
+}
+
+void MeshData::computeVertexQuadrics()
+{
+	TRACE_SCOPE("quadrics");
+	vertexQuadrics.resize(indexed_positions.size());
+	for (MeshIndex v = 0; v < indexed_positions.size(); v++)
+	{
+		std::map<Vector3, vector<MeshIndex>, customVec3Comparator>::iterator it = vertexTriangles.find(indexed_positions[v]);
+		if (it != vertexTriangles.end())
+			vertexQuadrics[v] = this->getTriangleVectorMatrix(it->second);
+		else vertexQuadrics[v].clear();
+	}
+}
+
+Matrix44 MeshData::getTriangleMatrix(const MeshIndex &index)
+{
+	Triangle tri = this->triangles[index];
+	Vector3 a = this->indexed_positions[tri.i];
+	Vector3 b = this->indexed_positions[tri.j];
+	Vector3 c = this->indexed_positions[tri.k];
+
+	Vector3 AB(b.x - a.x, b.y - a.y, b.z - a.z);
+	Vector3 BC(c.x - b.x, c.y - b.y, c.z - b.z);
+
+	Vector3 normal = AB.cross(BC);
+	normal.normalize();
+
+	float D(-(a.x * normal.x) - (a.y * normal.y) - (a.z * normal.z));
+
+	Matrix44 K;
+
+	K.M[0][0] = normal.x * normal.x;
+	K.M[0][1] = normal.x * normal.y;
+	K.M[0][2] = normal.x * normal.z;
+	K.M[0][3] = normal.x * D;
+	K.M[1][0] = normal.x * normal.y;
+	K.M[2][0] = normal.x * normal.z;
+	K.M[3][0] = normal.x * D;
+
+	K.M[1][1] = normal.y * normal.y;
+	K.M[1][2] = normal.y * normal.z;
+	K.M[1][3] = normal.y * D;
+	K.M[2][1] = normal.y * normal.z;
+	K.M[3][1] = normal.y * D;
+
+	K.M[2][2] = normal.z * normal.z;
+	K.M[2][3] = normal.z * D;
+	K.M[3][2] = normal.z * D;
+
+	K.M[3][3] = D * D;
+
+	return K;
+}
+
+Matrix44 MeshData::getTriangleVectorMatrix(const std::vector<MeshIndex> &indices)
+{
+	Matrix44 Q;
+
+	//cout << "Triangles: " << indices.size() << endl;
+	
+	if(indices.size() > 0)
+	{
+		Q = this->getTriangleMatrix(indices[0]);
+		for (size_t i = 1; i < indices.size(); ++i)
+		{
+			//cout << "\tTriangle: " << indices[i] << endl;
+			Q = Q + this->getTriangleMatrix(indices[i]);
+		}
+	}
+
+	return Q;
+}
+
+void MeshData::computeAllCosts()
+{
+	sort(edges.begin(), edges.end(), LessCost());
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		this->computeCost(&edges[i]);
+	}
+}
+
+void MeshData::computeCost(Edge *edge)
+{
+	this->computeCost(edge, this->getTriangleVectorMatrix(this->vertexTriangles[this->indexed_positions[edge->a]]) +
+		this->getTriangleVectorMatrix(this->vertexTriangles[this->indexed_positions[edge->b]]));
+}
+
+void MeshData::computeCost(Edge *edge, const Matrix44 &Q)
+{
+	TRACE_COUNT("recosts", 1);
+	edge->Q = Q;
+
+	Matrix44 temp = edge->Q;
+	temp.M[3][0] = 0;
+	temp.M[3][1] = 0;
+	temp.M[3][2] = 0;
+	temp.M[3][3] = 1;
+
+	temp.inverse();
+
+	Vector4 temp2(0, 0, 0, 1);
+
+	Vector4 tempW = multM4xV4(temp, temp2);
+
+	edge->w = Vector3(tempW.x, tempW.y, tempW.z);
+
+	Vector4 wQ = multV4xM4(tempW, edge->Q);
+
+	edge->cost = wQ.dot(tempW);
+}
+
+void MeshData::edgeContraction(const MeshIndex &numTriang, const double &maxError)
+{
+	TRACE_SCOPE("collapse");
+	MeshIndex triangSize = triangles.size();
+	MeshIndex rest = triangSize > numTriang ? triangSize - numTriang : 0;
+	collapses = 0;
+	if (rest > 0)
+	{
+		//the precomputed data describes the mesh before any contraction
+		this->dropPrecomputed();
+
+		MeshIndex count = 0;
+		while (count < ((rest) / 2))
+		{
+			if (progress)
+				progress((float)count / (rest / 2));
+			sort(edges.begin(), edges.end(), LessCost());
+			TRACE_COUNT("queue sorts", 1);
+			if (edges.empty() || edges[0].cost > maxError)
+			{
+				if (!edges.empty())
+					TRACE_COUNT("rejected collapses", 1);
+				break;
+			}
+			Edge e = edges[0];
+			edges.erase(edges.begin());
+			TRACE_COUNT("queue removals", 1);
+
+			vector<MeshIndex> triA = this->vertexTriangles[this->indexed_positions[e.a]];
+			vector<MeshIndex> triB = this->vertexTriangles[this->indexed_positions[e.b]];
+			//remove all the edges affected by the change
+			for (size_t i = 0; i < edges.size(); i++)
+			{
+				if ((std::find(triA.begin(), triA.end(), edges[i].triangleIndex) != triA.end())
+					|| (std::find(triB.begin(), triB.end(), edges[i].triangleIndex) != triB.end()))
+				{
+					this->edges.erase(this->edges.begin() + i);
+					TRACE_COUNT("queue removals", 1);
+					i -= 1;
+				}
+			}
+			//we remove the triangles containing the edge from triA
+			for (size_t i = 0; i < triA.size(); i++)
+			{
+				Triangle tri = this->triangles[triA[i]];
+				if (tri.containsIndex(e.b))
+				{
+					this->triangles.erase(this->triangles.begin() + triA[i]);
+					for (size_t j = 0; j < edges.size(); j++)
+					{
+						if (edges[j].triangleIndex > triA[i])
+							edges[j].triangleIndex -= 1;
+					}
+					this->vertexTriangles[this->indexed_positions[e.a]].erase(
+						this->vertexTriangles[this->indexed_positions[e.a]].begin() + i);
+					std::map<Vector3, vector<MeshIndex>, customVec3Comparator>::iterator it;
+					for (it = this->vertexTriangles.begin(); it != this->vertexTriangles.end(); ++it)
+					{
+						for (size_t j = 0; j < it->second.size(); j++)
+						{
+							if (it->second[j] == triA[i])
+								it->second.erase(it->second.begin() + (j--));
+							else if (it->second[j] > triA[i])
+								it->second[j] -= 1;
+						}
+					}
+					triA = this->vertexTriangles[this->indexed_positions[e.a]];
+					//triB = this->vertexTriangles[e.b];
+					i -= 1;
+				}
+			}
+			//refresh both vectors to get the new indices
+			triA = this->vertexTriangles[this->indexed_positions[e.a]];
+			triB = this->vertexTriangles[this->indexed_positions[e.b]];
+			//e.a is now the new vertex w
+			this->indexed_positions[e.a] = e.w;
+			//this->indexed_positions[e.b] = e.w;
+			//replace all indices of e.b for e.a
+			for (size_t i = 0; i < triB.size(); i++)
+			{
+				Triangle tri = this->triangles[triB[i]];
+				if (tri.i == e.b) this->triangles[triB[i]].i = e.a;
+				if (tri.j == e.b) this->triangles[triB[i]].j = e.a;
+				if (tri.k == e.b) this->triangles[triB[i]].k = e.a;
+			}
+			//add the triangles of the new vertex
+			vector<MeshIndex> auxTriangles;
+			auxTriangles.insert(auxTriangles.end(), triA.begin(), triA.end());
+			auxTriangles.insert(auxTriangles.end(), triB.begin(), triB.end());
+			this->vertexTriangles[this->indexed_positions[e.a]] = auxTriangles;
+			//add the edges of the new triangles and compute the cost
+			//update all edges that may ahve changed cost and w
+			for (size_t i = 0; i < triA.size(); i++)
+			{
+				Triangle t = this->triangles[triA[i]];
+				this->addEdge(t.i, t.j, triA[i]);
+				this->addEdge(t.j, t.k, triA[i]);
+				this->addEdge(t.k, t.i, triA[i]);
+
+				this->updateEdges(t.i);
+				this->updateEdges(t.j);
+				this->updateEdges(t.k);
+			}
+			for (size_t i = 0; i < triB.size(); i++)
+			{
+				Triangle t = this->triangles[triB[i]];
+				this->addEdge(t.i, t.j, triB[i]);
+				this->addEdge(t.j, t.k, triB[i]);
+				this->addEdge(t.k, t.i, triB[i]);
+
+				this->updateEdges(t.i);
+				this->updateEdges(t.j);
+				this->updateEdges(t.k);
+			}
+			//finally remove the vertex e.b from the list of vertices
+			this->indexed_positions.erase(this->indexed_positions.begin() + e.b);
+			if (this->indexed_normalsFinal.size())
+				this->indexed_normalsFinal.erase(this->indexed_normalsFinal.begin() + e.b);
+			if (this->indexed_uvsFinal.size())
+				this->indexed_uvsFinal.erase(this->indexed_uvsFinal.begin() + e.b);
+			//update all the indices inside the edges accordingly
+			for (size_t i = 0; i < this->edges.size(); i++)
+			{
+				if (this->edges[i].a > e.b) this->edges[i].a -= 1;
+				if (this->edges[i].b > e.b) this->edges[i].b -= 1;
+			}
+			//and inside the triangles as well
+			for (size_t i = 0; i < this->triangles.size(); i++)
+			{
+				if (this->triangles[i].i > e.b) this->triangles[i].i -= 1;
+				if (this->triangles[i].j > e.b) this->triangles[i].j -= 1;
+				if (this->triangles[i].k > e.b) this->triangles[i].k -= 1;
+			}
+			count++;
+			TRACE_COUNT("collapses", 1);
+			if ((count & 255) == 0)
+			{
+				TRACE_SAMPLE();
+				if (memory)
+					memory->sample(*this);
+			}
+		}
+
+		collapses = count;
+		//every erase shifts the arrays, the renderer uploads them whole
+		this->dirtyVertices = true;
+		this->dirtyTriangles = true;
+
+		TRACE_SAMPLE();
+		if (memory)
+			memory->endPhase("collapse", *this);
+		if (verbose)
+			cout << "Finished edgeContraction!" << endl;
+	}
+	else if (verbose)
+		cout << "Can't do a contraction to " << numTriang << " triangles, the resultant mesh would have less than 0 triangles" << endl;
+}
+
+MeshIndex MeshData::simplify(const SimplifyOptions &options)
+{
+	MeshIndex target = options.target_triangles;
+	if (options.target_ratio > 0)
+	{
+		MeshIndex ratioTarget = (MeshIndex)(triangles.size() * (double)options.target_ratio);
+		if (ratioTarget > target)
+			target = ratioTarget;
+	}
+	//with only an error bound we contract until the error is reached
+	if (target == 0 && options.max_error == DBL_MAX)
+	{
+		collapses = 0;
+		return triangles.size();
+	}
+
+	if (options.engine == SIMPLIFY_FAST)
+		return fastEdgeContraction(*this, target, options.max_error);
+	if (edges.empty() && !triangles.empty())
+		this->buildTopology();
+	this->edgeContraction(target, options.max_error);
+	return triangles.size();
+}
+
+bool MeshData::isLiveTriangle(const Triangle &t) const
+{
+	MeshIndex numVertices = indexed_positions.size();
+	return t.i != t.j && t.j != t.k && t.k != t.i && t.i < numVertices && t.j < numVertices && t.k < numVertices;
+}
+
+MeshIndex MeshData::remapUsedVertices(std::vector<MeshIndex> &remap) const
+{
+	remap.assign(indexed_positions.size(), 0);
+	for (size_t t = 0; t < triangles.size(); t++)
+	{
+		const Triangle &tri = triangles[t];
+		if (isLiveTriangle(tri))
+			remap[tri.i] = remap[tri.j] = remap[tri.k] = 1;
+	}
+	MeshIndex used = 0;
+	for (size_t v = 0; v < remap.size(); v++)
+		remap[v] = remap[v] ? ++used : 0;
+	return used;
+}
+
+void MeshData::copyGeometry(MeshData &out) const
+{
+	out.clear();
+	out.indexed_positions = indexed_positions;
+	out.indexed_normals = indexed_normals;
+	out.indexed_normalsFinal = indexed_normalsFinal;
+	out.indexed_uvs = indexed_uvs;
+	out.indexed_uvsFinal = indexed_uvsFinal;
+	out.triangles = triangles;
+}
+
+void MeshData::buildLODs(const vector<float> &ratios, vector<MeshData> &lods, SimplifyEngine engine)
+{
+	MeshIndex original = triangles.size();
+	lods.resize(ratios.size());
+	for (size_t i = 0; i < ratios.size(); i++)
+	{
+		//every level continues from the previous one, the ratios are relative to the original mesh
+		TRACE_SCOPE("lod level");
+		SimplifyOptions options;
+		options.target_triangles = (MeshIndex)(original * (double)ratios[i]);
+		options.engine = engine;
+		if (options.target_triangles < triangles.size())
+			this->simplify(options);
+		lods[i].verbose = verbose;
+		this->copyGeometry(lods[i]);
+	}
+}
+
+void MeshData::addEdge(const MeshIndex &i, const MeshIndex &j, const MeshIndex &triangleIndex)
+{
+	Edge e1(i, j);
+	e1.triangleIndex = triangleIndex;
+	this->computeCost(&e1);
+	this->insertEdge(e1);
+}
+
+void MeshData::insertEdge(const Edge &e)
+{
+	MeshIndex i = e.a, j = e.b;
+	edges.push_back(e);
+
+	TRACE_COUNT("queue inserts", 1);
+
+	Vector3 vi = this->indexed_positions[i];
+	Vector3 vj = this->indexed_positions[j];
+
+	vector<MeshIndex> vecAux1;
+	vecAux1.push_back(edges.size() - 1);
+	if (this->vertexEdges.find(vi) != this->vertexEdges.end())
+		this->vertexEdges[vi] = vecAux1;
+	else this->vertexEdges[vi].push_back(edges.size() - 1);
+
+	vector<MeshIndex> vecAux2;
+	vecAux2.push_back(edges.size() - 1);
+	if (this->vertexEdges.find(vj) != this->vertexEdges.end())
+		this->vertexEdges[vj] = vecAux2;
+	else this->vertexEdges[vj].push_back(edges.size() - 1);
+}
+
+void MeshData::updateEdges(const MeshIndex &i)
+{
+	Vector3 vec = this->indexed_positions[i];
+	if (this->vertexEdges.find(vec) != this->vertexEdges.end())
+	{
+		vector<MeshIndex> edgeIndices = this->vertexEdges[vec];
+		for (size_t i = 0; i < edgeIndices.size(); i++)
+		{
+			Edge e = this->edges[edgeIndices[i]];
+			this->computeCost(&e);
+		}
+	}
+}
+
+MeshIndex MeshData::totalTriangles()
+{
+	return triangles.size();
+}
+
+bool MeshData::saveOBJ(const char* filename) const
+{
+	return writeOBJ(filename, *this);
+}
+
+bool MeshData::savePLY(const char* filename, bool binary) const
+{
+	return writePLY(filename, *this, binary);
+}
+
+bool MeshData::saveSTL(const char* filename) const
+{
+	return writeSTL(filename, *this);
+}
+
+bool MeshData::saveCompressed(const char* filename) const
+{
+	return saveCompressedMesh(filename, *this);
+}
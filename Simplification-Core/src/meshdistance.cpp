@@ -0,0 +1,103 @@
+#include "meshdistance.h"
+#include "meshdata.h"
+#include "bvh.h"
+
+#include <algorithm>
+#include <random>
+#include <cfloat>
+
+#define DISTANCE_BLOCK 262144		//samples made and queried at a time, bounds the memory
+#define DISTANCE_MIN_SAMPLES 10000
+
+void measureOneSided(const MeshData &mesh, const TriangleBVH &bvh, const DistanceOptions &options, DistanceStats &stats)
+{
+	stats.hausdorff = stats.rms = stats.mean = 0;
+	stats.samples = 0;
+	if (bvh.empty())
+		return;
+
+	std::vector<MeshIndex> remap, vertices;
+	mesh.remapUsedVertices(remap);
+	for (size_t v = 0; v < remap.size(); v++)
+		if (remap[v])
+			vertices.push_back((MeshIndex)v);
+
+	//the area samples pick their triangle by binary search of the running area
+	std::vector<MeshIndex> live;
+	std::vector<double> areas;
+	double totalArea = 0;
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		if (!mesh.isLiveTriangle(tri))
+			continue;
+		DVector3 a(mesh.indexed_positions[tri.i]);
+		DVector3 n = (DVector3(mesh.indexed_positions[tri.j]) - a).cross(DVector3(mesh.indexed_positions[tri.k]) - a);
+		totalArea += 0.5 * sqrt(n.dot(n));
+		live.push_back((MeshIndex)t);
+		areas.push_back(totalArea);
+	}
+	unsigned long long areaSamples = 0;
+	if (totalArea > 0)
+		areaSamples = options.samples ? options.samples : std::max((unsigned long long)live.size(), (unsigned long long)DISTANCE_MIN_SAMPLES);
+
+	unsigned long long total = vertices.size() + areaSamples;
+	double maxSquared = 0, sumSquared = 0, sum = 0;
+	std::vector<DVector3> points;
+	std::vector<BVHClosestHit> hits;
+	//mt19937 gives the same numbers everywhere, the standard distributions don't
+	std::mt19937 random(options.seed);
+	for (unsigned long long blockStart = 0; blockStart < total; blockStart += DISTANCE_BLOCK)
+	{
+		unsigned long long blockEnd = std::min(total, blockStart + DISTANCE_BLOCK);
+		points.resize((size_t)(blockEnd - blockStart));
+		for (unsigned long long s = blockStart; s < blockEnd; s++)
+		{
+			if (s < vertices.size())
+			{
+				points[(size_t)(s - blockStart)] = DVector3(mesh.indexed_positions[vertices[(size_t)s]]);
+				continue;
+			}
+			double u = random() * (1.0 / 4294967296.0), v = random() * (1.0 / 4294967296.0), w = random() * (1.0 / 4294967296.0);
+			size_t t = std::upper_bound(areas.begin(), areas.end(), u * totalArea) - areas.begin();
+			const Triangle &tri = mesh.triangles[live[std::min(t, live.size() - 1)]];
+			double r = sqrt(v);
+			points[(size_t)(s - blockStart)] = DVector3(mesh.indexed_positions[tri.i]) * (1 - r) +
+				DVector3(mesh.indexed_positions[tri.j]) * (r * (1 - w)) + DVector3(mesh.indexed_positions[tri.k]) * (r * w);
+		}
+
+		//the queries are what takes the time, they run on the threads
+		bvh.closestBatch(points, hits, options.threads);
+		for (size_t h = 0; h < hits.size(); h++)
+		{
+			maxSquared = std::max(maxSquared, hits[h].distance);
+			if (blockStart + h >= vertices.size())
+			{
+				sumSquared += hits[h].distance;
+				sum += sqrt(hits[h].distance);
+			}
+		}
+	}
+
+	stats.samples = total;
+	stats.hausdorff = sqrt(maxSquared);
+	stats.rms = areaSamples ? sqrt(sumSquared / areaSamples) : 0;
+	stats.mean = areaSamples ? sum / areaSamples : 0;
+}
+
+bool measureDistance(const MeshData &a, const MeshData &b, const DistanceOptions &options, MeshDistance &distance)
+{
+	TriangleBVH bvhA, bvhB;
+	bvhA.build(a, options.threads);
+	bvhB.build(b, options.threads);
+	if (bvhA.empty() || bvhB.empty())
+		return false;
+
+	DVector3 extent = DVector3(bvhA.root().max) - DVector3(bvhA.root().min);
+	distance.diagonal = sqrt(extent.dot(extent));
+	measureOneSided(a, bvhB, options, distance.forward);
+	measureOneSided(b, bvhA, options, distance.backward);
+	distance.hausdorff = std::max(distance.forward.hausdorff, distance.backward.hausdorff);
+	distance.rms = std::max(distance.forward.rms, distance.backward.rms);
+	return true;
+}
@@ -0,0 +1,276 @@
+#include "meshgenerator.h"
+#include "meshdata.h"
+#include "vertexwelder.h"
+#include "memorystats.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static const char* s_shapeNames[] = { "sphere", "terrain", "torus", "scan" };
+
+bool parseMeshShape(const char* name, MeshShape &shape)
+{
+	for (int i = 0; i < 4; i++)
+	{
+		if (strcmp(name, s_shapeNames[i]) == 0)
+		{
+			shape = (MeshShape)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* meshShapeName(MeshShape shape)
+{
+	return s_shapeNames[shape];
+}
+
+//integer hash to [0, 1), the same on every platform unlike the standard distributions
+static float hashFloat(int x, int y, int z, unsigned int seed)
+{
+	uint32_t h = seed * 0x9E3779B1u ^ (uint32_t)x * 0x85EBCA77u ^ (uint32_t)y * 0xC2B2AE3Du ^ (uint32_t)z * 0x27D4EB2Fu;
+	h ^= h >> 15;
+	h *= 0x2C1B3C6Du;
+	h ^= h >> 12;
+	h *= 0x297A2D39u;
+	h ^= h >> 15;
+	return (h & 0xFFFFFF) / 16777216.0f;
+}
+
+static inline float smooth(float t)
+{
+	return t * t * (3 - 2 * t);
+}
+
+static inline float lerp(float a, float b, float t)
+{
+	return a + (b - a) * t;
+}
+
+//value noise in [-1, 1]
+static float valueNoise(float x, float y, float z, unsigned int seed)
+{
+	float fx = floorf(x), fy = floorf(y), fz = floorf(z);
+	int ix = (int)fx, iy = (int)fy, iz = (int)fz;
+	float tx = smooth(x - fx), ty = smooth(y - fy), tz = smooth(z - fz);
+
+	float c[2][2];
+	for (int dz = 0; dz < 2; dz++)
+		for (int dy = 0; dy < 2; dy++)
+			c[dz][dy] = lerp(hashFloat(ix, iy + dy, iz + dz, seed), hashFloat(ix + 1, iy + dy, iz + dz, seed), tx);
+	float v = lerp(lerp(c[0][0], c[0][1], ty), lerp(c[1][0], c[1][1], ty), tz);
+	return v * 2 - 1;
+}
+
+//octaves of noise halving the amplitude and doubling the frequency, about [-1, 1]
+static float fractalNoise(const Vector3 &p, int octaves, unsigned int seed)
+{
+	float sum = 0, amplitude = 1, total = 0, frequency = 1;
+	for (int i = 0; i < octaves; i++)
+	{
+		sum += valueNoise(p.x * frequency, p.y * frequency, p.z * frequency, seed + i) * amplitude;
+		total += amplitude;
+		amplitude *= 0.5f;
+		frequency *= 2;
+	}
+	return sum / total;
+}
+
+//area weighted normals of the triangles around every vertex
+static void computeNormals(MeshData &mesh)
+{
+	std::vector<Vector3> &normals = mesh.indexed_normalsFinal;
+	normals.assign(mesh.indexed_positions.size(), Vector3());
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		const Vector3 &a = mesh.indexed_positions[tri.i];
+		Vector3 n = (mesh.indexed_positions[tri.j] - a).cross(mesh.indexed_positions[tri.k] - a);
+		normals[tri.i] = normals[tri.i] + n;
+		normals[tri.j] = normals[tri.j] + n;
+		normals[tri.k] = normals[tri.k] + n;
+	}
+	for (size_t v = 0; v < normals.size(); v++)
+	{
+		if (normals[v].dot(normals[v]) > 0)
+			normals[v].normalize();
+		else normals[v].set(0, 1, 0);
+	}
+}
+
+//the two triangles of the quad a b c d, counter clockwise from outside
+static inline void addQuad(std::vector<Triangle> &triangles, MeshIndex a, MeshIndex b, MeshIndex c, MeshIndex d)
+{
+	triangles.push_back(Triangle(a, b, c));
+	triangles.push_back(Triangle(a, c, d));
+}
+
+//unit cube points are built from integers so the edges shared by two faces weld exactly
+static void generateCubeSphere(unsigned int n, MeshData &mesh)
+{
+	//fixed axis and its side, then the axes i and j run along, with i x j pointing out
+	static const int faces[6][4] = { { 0, 1, 1, 2 }, { 0, 0, 2, 1 }, { 1, 1, 2, 0 }, { 1, 0, 0, 2 }, { 2, 1, 0, 1 }, { 2, 0, 1, 0 } };
+
+	VertexWelder welder(mesh.indexed_positions);
+	std::vector<MeshIndex> row((n + 1) * 2);
+	mesh.triangles.reserve((size_t)n * n * 12);
+	for (int f = 0; f < 6; f++)
+	{
+		for (unsigned int j = 0; j <= n; j++)
+		{
+			MeshIndex* current = &row[(j & 1) * (n + 1)];
+			MeshIndex* previous = &row[((j + 1) & 1) * (n + 1)];
+			for (unsigned int i = 0; i <= n; i++)
+			{
+				int k[3];
+				k[faces[f][0]] = faces[f][1] ? n : 0;
+				k[faces[f][2]] = i;
+				k[faces[f][3]] = j;
+				current[i] = welder.add(Vector3((2 * k[0] - (int)n) / (float)n, (2 * k[1] - (int)n) / (float)n, (2 * k[2] - (int)n) / (float)n));
+				if (i > 0 && j > 0)
+					addQuad(mesh.triangles, previous[i - 1], previous[i], current[i], current[i - 1]);
+			}
+		}
+	}
+
+	const float pi = 3.14159265f;
+	mesh.indexed_uvsFinal.resize(mesh.indexed_positions.size());
+	for (size_t v = 0; v < mesh.indexed_positions.size(); v++)
+	{
+		Vector3 &p = mesh.indexed_positions[v];
+		p.normalize();
+		mesh.indexed_uvsFinal[v] = Vector2(atan2f(p.z, p.x) / (2 * pi) + 0.5f, acosf(p.y < -1 ? -1 : (p.y > 1 ? 1 : p.y)) / pi);
+	}
+}
+
+static void generateTerrain(unsigned int n, unsigned int seed, MeshData &mesh)
+{
+	mesh.indexed_positions.resize((size_t)(n + 1) * (n + 1));
+	mesh.indexed_uvsFinal.resize(mesh.indexed_positions.size());
+	for (unsigned int j = 0; j <= n; j++)
+	{
+		for (unsigned int i = 0; i <= n; i++)
+		{
+			size_t v = (size_t)j * (n + 1) + i;
+			float x = 2.0f * i / n - 1, z = 2.0f * j / n - 1;
+			mesh.indexed_positions[v] = Vector3(x, 0.25f * fractalNoise(Vector3(x * 3, 0, z * 3), 8, seed), z);
+			mesh.indexed_uvsFinal[v] = Vector2((float)i / n, (float)j / n);
+		}
+	}
+
+	//+y up: going along z then x turns counter clockwise seen from above
+	mesh.triangles.reserve((size_t)n * n * 2);
+	for (unsigned int j = 0; j < n; j++)
+	{
+		for (unsigned int i = 0; i < n; i++)
+		{
+			MeshIndex a = (MeshIndex)((size_t)j * (n + 1) + i);
+			addQuad(mesh.triangles, a, a + n + 1, a + n + 2, a + 1);
+		}
+	}
+}
+
+//nu segments around the ring, nv around the tube, both wrap around
+static void generateTorus(unsigned int nu, unsigned int nv, MeshData &mesh)
+{
+	const float pi = 3.14159265f;
+	mesh.indexed_positions.resize((size_t)nu * nv);
+	mesh.indexed_uvsFinal.resize(mesh.indexed_positions.size());
+	for (unsigned int a = 0; a < nu; a++)
+	{
+		float u = 2 * pi * a / nu;
+		//the tube gets down to a tenth of its width at six necks
+		float s = sinf(3 * u);
+		float r = 0.02f + 0.18f * s * s;
+		for (unsigned int b = 0; b < nv; b++)
+		{
+			float v = 2 * pi * b / nv;
+			size_t index = (size_t)a * nv + b;
+			float ring = 1 + r * cosf(v);
+			mesh.indexed_positions[index] = Vector3(ring * cosf(u), r * sinf(v), ring * sinf(u));
+			mesh.indexed_uvsFinal[index] = Vector2((float)a / nu, (float)b / nv);
+		}
+	}
+
+	mesh.triangles.reserve((size_t)nu * nv * 2);
+	for (unsigned int a = 0; a < nu; a++)
+	{
+		unsigned int a1 = (a + 1) % nu;
+		for (unsigned int b = 0; b < nv; b++)
+		{
+			unsigned int b1 = (b + 1) % nv;
+			addQuad(mesh.triangles, (MeshIndex)((size_t)a * nv + b), (MeshIndex)((size_t)a * nv + b1),
+				(MeshIndex)((size_t)a1 * nv + b1), (MeshIndex)((size_t)a1 * nv + b));
+		}
+	}
+}
+
+//bumps of a few percent of the radius and a jitter, the scanner noise, kept under the grid spacing so no triangle flips
+static void displaceScan(unsigned int n, unsigned int seed, MeshData &mesh)
+{
+	float jitterScale = 0.2f / n;
+	for (size_t v = 0; v < mesh.indexed_positions.size(); v++)
+	{
+		Vector3 &p = mesh.indexed_positions[v];
+		float jitter = hashFloat((int)(v & 0x7FFFFFFF), (int)(v >> 31), 0, seed ^ 0x5CA17u) - 0.5f;
+		p = p * (1 + 0.15f * fractalNoise(p * 2, 6, seed) + jitterScale * jitter);
+	}
+}
+
+bool generateMesh(MeshShape shape, unsigned long long triangles, unsigned int seed, MeshData &mesh)
+{
+	mesh.clear();
+	double count = (double)(triangles ? triangles : 1);
+
+	//size of the grids, and the vertices and triangles that come out of them
+	unsigned long long n = 0, nv = 0, vertices = 0, total = 0;
+	if (shape == SHAPE_TORUS)
+	{
+		//four times more segments around the ring than around the tube
+		nv = (unsigned long long)(sqrt(count / 8) + 0.5);
+		if (nv < 3)
+			nv = 3;
+		n = nv * 4;
+		vertices = n * nv;
+		total = vertices * 2;
+	}
+	else if (shape == SHAPE_TERRAIN)
+	{
+		n = (unsigned long long)(sqrt(count / 2) + 0.5);
+		if (n < 1)
+			n = 1;
+		vertices = (n + 1) * (n + 1);
+		total = n * n * 2;
+	}
+	else
+	{
+		n = (unsigned long long)(sqrt(count / 12) + 0.5);
+		if (n < 1)
+			n = 1;
+		vertices = n * n * 6 + 2;
+		total = n * n * 12;
+	}
+	if (!fitsMeshIndex((size_t)vertices) || !fitsMeshIndex((size_t)total) || n > 0x7FFFFFFF)
+	{
+		std::cerr << "Too many vertices or triangles for " << sizeof(MeshIndex) * 8 << " bit indices: " << total << " triangles" << std::endl;
+		return false;
+	}
+
+	switch (shape)
+	{
+	case SHAPE_TERRAIN: generateTerrain((unsigned int)n, seed, mesh); break;
+	case SHAPE_TORUS: generateTorus((unsigned int)n, (unsigned int)nv, mesh); break;
+	case SHAPE_SCAN: generateCubeSphere((unsigned int)n, mesh); displaceScan((unsigned int)n, seed, mesh); break;
+	default: generateCubeSphere((unsigned int)n, mesh); break;
+	}
+
+	computeNormals(mesh);
+	//the loaders keep the per vertex attributes in both arrays, the writers look at either
+	mesh.indexed_normals = mesh.indexed_normalsFinal;
+	mesh.indexed_uvs = mesh.indexed_uvsFinal;
+	if (mesh.memory)
+		mesh.memory->endPhase("generate", mesh);
+	return true;
+}
@@ -0,0 +1,161 @@
+#include "meshworker.h"
+#include <chrono>
+#include <cstdio>
+
+MeshWorker::MeshWorker() : pool(1)
+{
+	busy = false;
+	result = RESULT_NONE;
+	progress = -1;
+	back.verbose = false;
+}
+
+bool MeshWorker::start(const std::string &text)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (busy)
+		return false;
+	busy = true;
+	progress = -1;
+	status = text;
+	return true;
+}
+
+void MeshWorker::finish(int kind, const std::string &text)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	result = kind;
+	busy = kind != RESULT_NONE; //stays busy until the result is taken
+	progress = -1;
+	status = text;
+}
+
+static double secondsSince(std::chrono::high_resolution_clock::time_point start)
+{
+	return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+bool MeshWorker::load(const std::string &filename)
+{
+	if (!this->start("Loading " + filename))
+		return false;
+
+	pool.enqueue([this, filename]() {
+		std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+		back.progress = nullptr;
+		bool ok = back.loadCached(filename.c_str());
+
+		char text[256];
+		if (ok)
+			snprintf(text, sizeof(text), "Loaded %s, %llu triangles in %.2f s", filename.c_str(), (unsigned long long)back.triangles.size(), secondsSince(start));
+		else snprintf(text, sizeof(text), "Can't load %s", filename.c_str());
+		this->finish(ok ? RESULT_MESH : RESULT_NONE, text);
+	});
+	return true;
+}
+
+bool MeshWorker::simplify(const MeshData &source, MeshIndex targetTriangles)
+{
+	char text[256];
+	snprintf(text, sizeof(text), "Simplifying to %llu triangles", (unsigned long long)targetTriangles);
+	if (!this->start(text))
+		return false;
+
+	//copied here, the caller keeps drawing and uploading source while the job runs. Only the geometry, the
+	//fast engine builds its own topology
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	source.copyGeometry(back);
+	back.verbose = false;
+
+	pool.enqueue([this, start, targetTriangles]() {
+		back.progress = [this](float fraction) { progress = fraction; };
+		SimplifyOptions options;
+		options.target_triangles = targetTriangles;
+		options.engine = SIMPLIFY_FAST;
+		back.simplify(options);
+		back.progress = nullptr;
+
+		char text[256];
+		snprintf(text, sizeof(text), "Simplified to %llu triangles in %.2f s", (unsigned long long)back.triangles.size(), secondsSince(start));
+		this->finish(RESULT_MESH, text);
+	});
+	return true;
+}
+
+bool MeshWorker::buildLODs(const MeshData &source, const std::vector<float> &ratios)
+{
+	if (ratios.empty() || !this->start("Building " + std::to_string(ratios.size()) + " LODs"))
+		return false;
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	source.copyGeometry(back);
+	back.verbose = false;
+
+	pool.enqueue([this, start, ratios]() {
+		//the levels are contracted one after the other, the progress is over the whole chain.
+		//The fast engine erases the triangles at the end of a level, so the level running is the first
+		//whose target is below the triangles left
+		double original = (double)back.triangles.size();
+		double removed = original - (MeshIndex)(original * (double)ratios.back());
+		back.progress = [this, original, removed, ratios](float fraction) {
+			double levelStart = (double)back.triangles.size();
+			for (size_t l = 0; l < ratios.size() && removed > 0; l++)
+			{
+				double target = (MeshIndex)(original * (double)ratios[l]);
+				if (target < levelStart)
+				{
+					progress = (float)((original - levelStart + fraction * (levelStart - target)) / removed);
+					break;
+				}
+			}
+		};
+		back.buildLODs(ratios, backLods, SIMPLIFY_FAST);
+		back.progress = nullptr;
+
+		char text[256];
+		snprintf(text, sizeof(text), "Built %u LODs down to %llu triangles in %.2f s", (unsigned int)backLods.size(),
+			(unsigned long long)backLods.back().triangles.size(), secondsSince(start));
+		this->finish(RESULT_LODS, text);
+	});
+	return true;
+}
+
+bool MeshWorker::isBusy() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return busy;
+}
+
+float MeshWorker::getProgress() const
+{
+	return progress;
+}
+
+std::string MeshWorker::getStatus() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return status;
+}
+
+bool MeshWorker::takeResult(MeshData &front)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (result != RESULT_MESH)
+		return false;
+	front.swap(back);
+	result = RESULT_NONE;
+	busy = false;
+	return true;
+}
+
+bool MeshWorker::takeLODs(std::vector<MeshData> &front)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if (result != RESULT_LODS)
+		return false;
+	front.swap(backLods);
+	backLods.clear();
+	result = RESULT_NONE;
+	busy = false;
+	return true;
+}
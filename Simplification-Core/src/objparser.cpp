@@ -0,0 +1,211 @@
+#include "objparser.h"
+#include "textscan.h"
+#include "threadpool.h"
+#include <algorithm>
+
+//OBJ indices start at 1, negative ones are relative to the last element read
+static inline ObjIndex resolveIndex(long long index, size_t count)
+{
+	if (index > 0)
+		return (ObjIndex)(index - 1);
+	if (index < 0)
+		return (ObjIndex)(count + index);
+	return -1;
+}
+
+//reads one v, v/vt, v//vn or v/vt/vn group, relative gets one bit per component using a negative index
+static const char* scanCorner(const char* p, const char* end, const ObjData &out, ObjCorner &corner, unsigned int &relative)
+{
+	long long index = 0;
+	const char* after = scanInt(p, end, index);
+	if (after == p)
+		return p;
+	corner.v = resolveIndex(index, out.positions.size());
+	corner.vt = corner.vn = -1;
+	relative = index < 0 ? 1 : 0;
+	p = after;
+
+	if (p < end && *p == '/')
+	{
+		p++;
+		index = 0;
+		p = scanInt(p, end, index);
+		corner.vt = resolveIndex(index, out.uvs.size());
+		if (index < 0) relative |= 2;
+		if (p < end && *p == '/')
+		{
+			p++;
+			index = 0;
+			p = scanInt(p, end, index);
+			corner.vn = resolveIndex(index, out.normals.size());
+			if (index < 0) relative |= 4;
+		}
+	}
+	return p;
+}
+
+static inline void pushCorner(ObjData &out, const ObjCorner &corner, unsigned int relative)
+{
+	if (relative)
+	{
+		size_t slot = out.corners.size() * 3;
+		for (unsigned int k = 0; k < 3; k++)
+			if (relative & (1 << k))
+				out.relative.push_back(slot + k);
+	}
+	out.corners.push_back(corner);
+}
+
+void parseOBJ(const char* begin, const char* end, ObjData &out)
+{
+	const char* p = begin;
+
+	while (p < end)
+	{
+		p = skipBlanks(p, end);
+		if (p == end)
+			break;
+
+		if (p[0] == 'v' && p + 1 < end && isBlank(p[1]))
+		{
+			Vector3 v;
+			p = skipBlanks(p + 2, end);
+			p = skipBlanks(scanFloat(p, end, v.x), end);
+			p = skipBlanks(scanFloat(p, end, v.y), end);
+			p = scanFloat(p, end, v.z);
+			out.positions.push_back(v);
+		}
+		else if (p[0] == 'v' && p + 2 < end && p[1] == 't' && isBlank(p[2]))
+		{
+			Vector2 uv;
+			p = skipBlanks(p + 3, end);
+			p = skipBlanks(scanFloat(p, end, uv.x), end);
+			p = scanFloat(p, end, uv.y);
+			out.uvs.push_back(uv);
+		}
+		else if (p[0] == 'v' && p + 2 < end && p[1] == 'n' && isBlank(p[2]))
+		{
+			Vector3 n;
+			p = skipBlanks(p + 3, end);
+			p = skipBlanks(scanFloat(p, end, n.x), end);
+			p = skipBlanks(scanFloat(p, end, n.y), end);
+			p = scanFloat(p, end, n.z);
+			out.normals.push_back(n);
+		}
+		else if (p[0] == 'f' && p + 1 < end && isBlank(p[1]))
+		{
+			ObjCorner first, previous, current;
+			unsigned int firstRelative = 0, previousRelative = 0, currentRelative = 0;
+			int count = 0;
+			p = skipBlanks(p + 2, end);
+			while (p < end && !isEndOfLine(*p))
+			{
+				const char* after = scanCorner(p, end, out, current, currentRelative);
+				if (after == p) //not an index, ignore the rest of the line
+					break;
+				p = skipBlanks(after, end);
+
+				if (count == 0)
+				{
+					first = current;
+					firstRelative = currentRelative;
+				}
+				else if (count >= 2)
+				{
+					pushCorner(out, first, firstRelative);
+					pushCorner(out, previous, previousRelative);
+					pushCorner(out, current, currentRelative);
+				}
+				previous = current;
+				previousRelative = currentRelative;
+				count++;
+			}
+		}
+
+		//comments, groups, materials and whatever is left of the line
+		p = skipLine(p, end);
+	}
+}
+
+//below this size splitting the file costs more than it saves
+#define OBJ_MIN_CHUNK_SIZE (4 << 20)
+
+void parseOBJParallel(const char* begin, const char* end, ObjData &out, unsigned int numThreads)
+{
+	if (numThreads == 0)
+		numThreads = std::thread::hardware_concurrency();
+	size_t size = end - begin;
+	size_t numChunks = numThreads * 4;
+	if (numChunks > size / OBJ_MIN_CHUNK_SIZE)
+		numChunks = size / OBJ_MIN_CHUNK_SIZE;
+	if (numThreads <= 1 || numChunks <= 1)
+	{
+		parseOBJ(begin, end, out);
+		return;
+	}
+
+	//chunk boundaries start right after a newline so no line is split
+	std::vector<const char*> bounds(numChunks + 1);
+	bounds[0] = begin;
+	bounds[numChunks] = end;
+	for (size_t i = 1; i < numChunks; i++)
+	{
+		const char* p = begin + size / numChunks * i;
+		if (p < bounds[i - 1])
+			p = bounds[i - 1];
+		bounds[i] = skipLine(p, end);
+	}
+
+	std::vector<ObjData> chunks(numChunks);
+	ThreadPool pool(numThreads);
+	for (size_t i = 0; i < numChunks; i++)
+		pool.enqueue([&, i]() { parseOBJ(bounds[i], bounds[i + 1], chunks[i]); });
+	pool.wait();
+
+	//prefix sum of the counts gives where every chunk goes in the final arrays
+	struct Offsets { size_t positions, uvs, normals, corners; };
+	std::vector<Offsets> offsets(numChunks + 1);
+	offsets[0].positions = out.positions.size();
+	offsets[0].uvs = out.uvs.size();
+	offsets[0].normals = out.normals.size();
+	offsets[0].corners = out.corners.size();
+	for (size_t i = 0; i < numChunks; i++)
+	{
+		offsets[i + 1].positions = offsets[i].positions + chunks[i].positions.size();
+		offsets[i + 1].uvs = offsets[i].uvs + chunks[i].uvs.size();
+		offsets[i + 1].normals = offsets[i].normals + chunks[i].normals.size();
+		offsets[i + 1].corners = offsets[i].corners + chunks[i].corners.size();
+	}
+
+	out.positions.resize(offsets[numChunks].positions);
+	out.uvs.resize(offsets[numChunks].uvs);
+	out.normals.resize(offsets[numChunks].normals);
+	out.corners.resize(offsets[numChunks].corners);
+
+	for (size_t i = 0; i < numChunks; i++)
+	{
+		pool.enqueue([&, i]() {
+			ObjData &chunk = chunks[i];
+			const Offsets &base = offsets[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), out.positions.begin() + base.positions);
+			std::copy(chunk.uvs.begin(), chunk.uvs.end(), out.uvs.begin() + base.uvs);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), out.normals.begin() + base.normals);
+
+			//relative indices were resolved against this chunk alone
+			const ObjIndex shift[3] = { (ObjIndex)base.positions, (ObjIndex)base.uvs, (ObjIndex)base.normals };
+			for (size_t r = 0; r < chunk.relative.size(); r++)
+			{
+				ObjCorner &corner = chunk.corners[chunk.relative[r] / 3];
+				corner.component(chunk.relative[r] % 3) += shift[chunk.relative[r] % 3];
+			}
+			std::copy(chunk.corners.begin(), chunk.corners.end(), out.corners.begin() + base.corners);
+
+			//free the chunk as soon as it is copied to keep the peak memory down
+			std::vector<Vector3>().swap(chunk.positions);
+			std::vector<Vector2>().swap(chunk.uvs);
+			std::vector<Vector3>().swap(chunk.normals);
+			std::vector<ObjCorner>().swap(chunk.corners);
+		});
+	}
+	pool.wait();
+}
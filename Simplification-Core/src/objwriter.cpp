@@ -0,0 +1,107 @@
+#include "objwriter.h"
+#include "meshdata.h"
+#include "textformat.h"
+#include "threadpool.h"
+#include "bufferedfile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#define OBJWRITER_MAX_LINE 256 //longest line we can format
+
+static inline char* formatVector(char* out, const char* prefix, const float* v, int n)
+{
+	while (*prefix) *out++ = *prefix++;
+	for (int i = 0; i < n; i++)
+	{
+		*out++ = ' ';
+		out = formatFloat(out, v[i]);
+	}
+	*out++ = '\n';
+	return out;
+}
+
+bool writeOBJ(const char* filename, const MeshData &mesh)
+{
+	MeshIndex numVertices = mesh.indexed_positions.size();
+	bool hasNormals = mesh.indexed_normalsFinal.size() == numVertices && numVertices;
+	bool hasUvs = mesh.indexed_uvsFinal.size() == numVertices && numVertices;
+
+	std::vector<MeshIndex> remap;
+	mesh.remapUsedVertices(remap);
+
+	FILE* f = fopen(filename, "wb");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << filename << std::endl;
+		return false;
+	}
+
+	BufferedFile out(f);
+	for (MeshIndex v = 0; v < numVertices; v++)
+		if (remap[v])
+			out.commit(formatVector(out.reserve(OBJWRITER_MAX_LINE), "v", mesh.indexed_positions[v].v, 3));
+	if (hasUvs)
+		for (MeshIndex v = 0; v < numVertices; v++)
+			if (remap[v])
+				out.commit(formatVector(out.reserve(OBJWRITER_MAX_LINE), "vt", mesh.indexed_uvsFinal[v].value, 2));
+	if (hasNormals)
+		for (MeshIndex v = 0; v < numVertices; v++)
+			if (remap[v])
+				out.commit(formatVector(out.reserve(OBJWRITER_MAX_LINE), "vn", mesh.indexed_normalsFinal[v].v, 3));
+
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		if (!mesh.isLiveTriangle(tri))
+			continue;
+
+		const MeshIndex corners[3] = { remap[tri.i], remap[tri.j], remap[tri.k] };
+		char* p = out.reserve(OBJWRITER_MAX_LINE);
+		*p++ = 'f';
+		for (int k = 0; k < 3; k++)
+		{
+			*p++ = ' ';
+			p = formatUInt(p, corners[k]);
+			if (hasUvs || hasNormals)
+			{
+				*p++ = '/';
+				if (hasUvs)
+					p = formatUInt(p, corners[k]);
+				if (hasNormals)
+				{
+					*p++ = '/';
+					p = formatUInt(p, corners[k]);
+				}
+			}
+		}
+		*p++ = '\n';
+		out.commit(p);
+	}
+
+	bool ok = out.flush();
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		std::cerr << "Error writing file: " << filename << std::endl;
+	return ok;
+}
+
+bool writeOBJs(const std::vector<const MeshData*> &meshes, const std::vector<std::string> &filenames, unsigned int numThreads)
+{
+	if (meshes.size() != filenames.size())
+		return false;
+
+	std::vector<char> results(meshes.size(), 0);
+	{
+		ThreadPool pool(numThreads);
+		for (unsigned int i = 0; i < meshes.size(); i++)
+			pool.enqueue([&, i]() { results[i] = writeOBJ(filenames[i].c_str(), *meshes[i]); });
+		pool.wait();
+	}
+
+	for (unsigned int i = 0; i < results.size(); i++)
+		if (!results[i])
+			return false;
+	return true;
+}
@@ -0,0 +1,647 @@
+#include "plyfile.h"
+#include "meshdata.h"
+#include "textscan.h"
+#include "textformat.h"
+#include "bufferedfile.h"
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+#define PLY_VERTEX_BLOCK 1024	//vertices decoded per pass, small enough for the block to stay in cache
+#define PLY_MAX_LINE 256		//longest ascii line we write
+
+enum PlyType { PLY_NONE, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64 };
+static const size_t plyTypeSize[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+enum PlyFormat { PLY_ASCII, PLY_BINARY_LE, PLY_BINARY_BE };
+
+struct PlyProperty
+{
+	std::string name;
+	PlyType type;		//of the value, or of the items of a list
+	PlyType countType;	//PLY_NONE unless it is a list
+};
+
+struct PlyElement
+{
+	std::string name;
+	size_t count;
+	std::vector<PlyProperty> properties;
+};
+
+//vertex properties we keep
+enum PlySlot { SLOT_X, SLOT_Y, SLOT_Z, SLOT_NX, SLOT_NY, SLOT_NZ, SLOT_U, SLOT_V, NUM_SLOTS };
+
+static PlyType parseType(const std::string &name)
+{
+	if (name == "char" || name == "int8") return PLY_INT8;
+	if (name == "uchar" || name == "uint8") return PLY_UINT8;
+	if (name == "short" || name == "int16") return PLY_INT16;
+	if (name == "ushort" || name == "uint16") return PLY_UINT16;
+	if (name == "int" || name == "int32") return PLY_INT32;
+	if (name == "uint" || name == "uint32") return PLY_UINT32;
+	if (name == "float" || name == "float32") return PLY_FLOAT32;
+	if (name == "double" || name == "float64") return PLY_FLOAT64;
+	return PLY_NONE;
+}
+
+static int vertexSlot(const PlyProperty &property)
+{
+	const std::string &name = property.name;
+	if (property.countType != PLY_NONE) return -1;
+	if (name == "x") return SLOT_X;
+	if (name == "y") return SLOT_Y;
+	if (name == "z") return SLOT_Z;
+	if (name == "nx") return SLOT_NX;
+	if (name == "ny") return SLOT_NY;
+	if (name == "nz") return SLOT_NZ;
+	if (name == "u" || name == "s" || name == "texture_u" || name == "texture_s") return SLOT_U;
+	if (name == "v" || name == "t" || name == "texture_v" || name == "texture_t") return SLOT_V;
+	return -1;
+}
+
+static bool isIndexList(const PlyProperty &property)
+{
+	return property.countType != PLY_NONE && (property.name == "vertex_indices" || property.name == "vertex_index");
+}
+
+static bool isFixedSize(const PlyElement &element)
+{
+	for (size_t i = 0; i < element.properties.size(); i++)
+		if (element.properties[i].countType != PLY_NONE)
+			return false;
+	return true;
+}
+
+static std::string nextWord(const char* &p, const char* end)
+{
+	p = skipBlanks(p, end);
+	const char* start = p;
+	p = skipToken(p, end);
+	return std::string(start, p);
+}
+
+//fills format and elements, body is set to the first byte after end_header
+static bool parseHeader(const char* begin, const char* end, PlyFormat &format, std::vector<PlyElement> &elements, const char* &body)
+{
+	const char* p = begin;
+	if (end - p < 3 || memcmp(p, "ply", 3) != 0)
+		return false;
+	p = skipLine(p, end);
+
+	bool hasFormat = false;
+	while (p < end)
+	{
+		std::string keyword = nextWord(p, end);
+		if (keyword == "format")
+		{
+			std::string name = nextWord(p, end);
+			if (name == "ascii") format = PLY_ASCII;
+			else if (name == "binary_little_endian") format = PLY_BINARY_LE;
+			else if (name == "binary_big_endian") format = PLY_BINARY_BE;
+			else return false;
+			hasFormat = true;
+		}
+		else if (keyword == "element")
+		{
+			PlyElement element;
+			element.name = nextWord(p, end);
+			element.count = (size_t)strtoull(nextWord(p, end).c_str(), NULL, 10);
+			elements.push_back(element);
+		}
+		else if (keyword == "property")
+		{
+			if (elements.empty())
+				return false;
+			PlyProperty property;
+			std::string type = nextWord(p, end);
+			if (type == "list")
+			{
+				property.countType = parseType(nextWord(p, end));
+				property.type = parseType(nextWord(p, end));
+				if (property.countType == PLY_NONE || property.countType >= PLY_FLOAT32)
+					return false;
+			}
+			else
+			{
+				property.countType = PLY_NONE;
+				property.type = parseType(type);
+			}
+			if (property.type == PLY_NONE)
+				return false;
+			property.name = nextWord(p, end);
+			elements.back().properties.push_back(property);
+		}
+		else if (keyword == "end_header")
+		{
+			body = skipLine(p, end);
+			return hasFormat;
+		}
+
+		//comment, obj_info and anything we don't know
+		p = skipLine(p, end);
+	}
+	return false;
+}
+
+template<class T, bool swap> static inline T load(const char* p)
+{
+	T value;
+	if (swap)
+	{
+		char bytes[sizeof(T)];
+		for (size_t i = 0; i < sizeof(T); i++)
+			bytes[i] = p[sizeof(T) - 1 - i];
+		memcpy(&value, bytes, sizeof(T));
+	}
+	else memcpy(&value, p, sizeof(T));
+	return value;
+}
+
+template<bool swap> static double loadValue(const char* p, PlyType type)
+{
+	switch (type)
+	{
+		case PLY_INT8: return load<int8_t, swap>(p);
+		case PLY_UINT8: return load<uint8_t, swap>(p);
+		case PLY_INT16: return load<int16_t, swap>(p);
+		case PLY_UINT16: return load<uint16_t, swap>(p);
+		case PLY_INT32: return load<int32_t, swap>(p);
+		case PLY_UINT32: return load<uint32_t, swap>(p);
+		case PLY_FLOAT32: return load<float, swap>(p);
+		case PLY_FLOAT64: return load<double, swap>(p);
+		default: return 0;
+	}
+}
+
+//the readers below go value by value whatever the layout, used for ascii files and for the binary
+//layouts the specialized loops don't cover
+class AsciiReader
+{
+public:
+	AsciiReader(const char* begin, const char* end) : p(begin), end(end), failed(false) {}
+
+	double read(PlyType)
+	{
+		while (p < end && (isBlank(*p) || isEndOfLine(*p))) p++;
+		double value = 0;
+		const char* after = scanDouble(p, end, value);
+		if (after == p)
+			failed = true;
+		p = after;
+		return value;
+	}
+
+	const char* p;
+	const char* end;
+	bool failed;
+};
+
+template<bool swap> class BinaryReader
+{
+public:
+	BinaryReader(const char* begin, const char* end) : p(begin), end(end), failed(false) {}
+
+	double read(PlyType type)
+	{
+		size_t size = plyTypeSize[type];
+		if ((size_t)(end - p) < size)
+		{
+			failed = true;
+			return 0;
+		}
+		double value = loadValue<swap>(p, type);
+		p += size;
+		return value;
+	}
+
+	const char* p;
+	const char* end;
+	bool failed;
+};
+
+static void addPolygon(const MeshIndex* indices, size_t count, std::vector<Triangle> &triangles)
+{
+	for (size_t k = 2; k < count; k++)
+		triangles.push_back(Triangle(indices[0], indices[k - 1], indices[k]));
+}
+
+static void prepareVertices(const PlyElement &element, PlyData &out)
+{
+	bool hasNormals = false, hasUvs = false;
+	for (size_t i = 0; i < element.properties.size(); i++)
+	{
+		int slot = vertexSlot(element.properties[i]);
+		hasNormals = hasNormals || (slot >= SLOT_NX && slot <= SLOT_NZ);
+		hasUvs = hasUvs || slot >= SLOT_U;
+	}
+	out.positions.resize(element.count);
+	if (hasNormals)
+		out.normals.resize(element.count);
+	if (hasUvs)
+		out.uvs.resize(element.count);
+}
+
+//where a vertex slot goes, and how many floats to jump to the next vertex
+static float* slotTarget(PlyData &out, int slot, size_t vertex, size_t &stride)
+{
+	if (slot < SLOT_NX)
+	{
+		stride = sizeof(Vector3) / sizeof(float);
+		return out.positions[vertex].v + slot;
+	}
+	if (slot < SLOT_U)
+	{
+		stride = sizeof(Vector3) / sizeof(float);
+		return out.normals[vertex].v + slot - SLOT_NX;
+	}
+	stride = sizeof(Vector2) / sizeof(float);
+	return out.uvs[vertex].value + slot - SLOT_U;
+}
+
+template<class Reader> static void readElement(Reader &reader, const PlyElement &element, PlyData &out, bool isVertex, bool isFace)
+{
+	const std::vector<PlyProperty> &properties = element.properties;
+	std::vector<int> slots(properties.size(), -1);
+	if (isVertex)
+		for (size_t i = 0; i < properties.size(); i++)
+			slots[i] = vertexSlot(properties[i]);
+
+	std::vector<MeshIndex> polygon;
+	for (size_t e = 0; e < element.count && !reader.failed; e++)
+	{
+		for (size_t i = 0; i < properties.size() && !reader.failed; i++)
+		{
+			const PlyProperty &property = properties[i];
+			if (property.countType == PLY_NONE)
+			{
+				double value = reader.read(property.type);
+				size_t stride;
+				if (slots[i] >= 0)
+					*slotTarget(out, slots[i], e, stride) = (float)value;
+				continue;
+			}
+
+			double count = reader.read(property.countType);
+			if (count < 0)
+			{
+				reader.failed = true;
+				break;
+			}
+			bool keep = isFace && isIndexList(property);
+			polygon.clear();
+			for (size_t k = 0; k < (size_t)count && !reader.failed; k++)
+			{
+				double index = reader.read(property.type);
+				if (keep)
+					polygon.push_back((MeshIndex)(long long)index);
+			}
+			if (keep && !reader.failed)
+				addPolygon(polygon.data(), polygon.size(), out.triangles);
+		}
+	}
+}
+
+template<class T, bool swap> static void decodeColumn(const char* src, size_t srcStride, size_t count, float* dst, size_t dstStride)
+{
+	for (size_t i = 0; i < count; i++)
+		dst[i * dstStride] = (float)load<T, swap>(src + i * srcStride);
+}
+
+template<bool swap> static void decodeColumn(PlyType type, const char* src, size_t srcStride, size_t count, float* dst, size_t dstStride)
+{
+	switch (type)
+	{
+		case PLY_INT8: decodeColumn<int8_t, swap>(src, srcStride, count, dst, dstStride); break;
+		case PLY_UINT8: decodeColumn<uint8_t, swap>(src, srcStride, count, dst, dstStride); break;
+		case PLY_INT16: decodeColumn<int16_t, swap>(src, srcStride, count, dst, dstStride); break;
+		case PLY_UINT16: decodeColumn<uint16_t, swap>(src, srcStride, count, dst, dstStride); break;
+		case PLY_INT32: decodeColumn<int32_t, swap>(src, srcStride, count, dst, dstStride); break;
+		case PLY_UINT32: decodeColumn<uint32_t, swap>(src, srcStride, count, dst, dstStride); break;
+		case PLY_FLOAT32: decodeColumn<float, swap>(src, srcStride, count, dst, dstStride); break;
+		case PLY_FLOAT64: decodeColumn<double, swap>(src, srcStride, count, dst, dstStride); break;
+		default: break;
+	}
+}
+
+//vertices without list properties, returns NULL if the file is too short
+template<bool swap> static const char* decodeVertices(const char* p, const char* end, const PlyElement &element, PlyData &out)
+{
+	const std::vector<PlyProperty> &properties = element.properties;
+	std::vector<size_t> offsets(properties.size());
+	size_t stride = 0;
+	for (size_t i = 0; i < properties.size(); i++)
+	{
+		offsets[i] = stride;
+		stride += plyTypeSize[properties[i].type];
+	}
+	if (stride == 0)
+		return p;
+	if (element.count > (size_t)(end - p) / stride)
+		return NULL;
+
+	for (size_t block = 0; block < element.count; block += PLY_VERTEX_BLOCK)
+	{
+		size_t count = std::min((size_t)PLY_VERTEX_BLOCK, element.count - block);
+		const char* src = p + block * stride;
+		for (size_t i = 0; i < properties.size(); i++)
+		{
+			int slot = vertexSlot(properties[i]);
+			if (slot < 0)
+				continue;
+			size_t dstStride;
+			float* dst = slotTarget(out, slot, block, dstStride);
+			decodeColumn<swap>(properties[i].type, src + offsets[i], stride, count, dst, dstStride);
+		}
+	}
+	return p + element.count * stride;
+}
+
+//faces whose only list is the index list, before and after are the bytes of the scalar properties around it
+template<class C, class I, bool swap> static const char* decodeFaces(const char* p, const char* end, size_t count, size_t before, size_t after, std::vector<Triangle> &triangles)
+{
+	for (size_t f = 0; f < count; f++)
+	{
+		if ((size_t)(end - p) < before + sizeof(C))
+			return NULL;
+		p += before;
+		long long n = (long long)load<C, swap>(p);
+		p += sizeof(C);
+		if (n < 0 || (size_t)(end - p) < (size_t)n * sizeof(I) + after)
+			return NULL;
+
+		if (n >= 3)
+		{
+			MeshIndex first = (MeshIndex)load<I, swap>(p);
+			MeshIndex previous = (MeshIndex)load<I, swap>(p + sizeof(I));
+			for (long long k = 2; k < n; k++)
+			{
+				MeshIndex current = (MeshIndex)load<I, swap>(p + k * sizeof(I));
+				triangles.push_back(Triangle(first, previous, current));
+				previous = current;
+			}
+		}
+		p += (size_t)n * sizeof(I) + after;
+	}
+	return p;
+}
+
+template<class C, bool swap> static const char* decodeFaces(PlyType indexType, const char* p, const char* end, size_t count, size_t before, size_t after, std::vector<Triangle> &triangles)
+{
+	switch (indexType)
+	{
+		case PLY_INT16: return decodeFaces<C, int16_t, swap>(p, end, count, before, after, triangles);
+		case PLY_UINT16: return decodeFaces<C, uint16_t, swap>(p, end, count, before, after, triangles);
+		case PLY_INT32: return decodeFaces<C, int32_t, swap>(p, end, count, before, after, triangles);
+		case PLY_UINT32: return decodeFaces<C, uint32_t, swap>(p, end, count, before, after, triangles);
+		default: return NULL;
+	}
+}
+
+template<bool swap> static const char* decodeFaces(const PlyProperty &list, const char* p, const char* end, size_t count, size_t before, size_t after, std::vector<Triangle> &triangles)
+{
+	switch (list.countType)
+	{
+		case PLY_INT8: return decodeFaces<int8_t, swap>(list.type, p, end, count, before, after, triangles);
+		case PLY_UINT8: return decodeFaces<uint8_t, swap>(list.type, p, end, count, before, after, triangles);
+		case PLY_INT16: return decodeFaces<int16_t, swap>(list.type, p, end, count, before, after, triangles);
+		case PLY_UINT16: return decodeFaces<uint16_t, swap>(list.type, p, end, count, before, after, triangles);
+		case PLY_INT32: return decodeFaces<int32_t, swap>(list.type, p, end, count, before, after, triangles);
+		case PLY_UINT32: return decodeFaces<uint32_t, swap>(list.type, p, end, count, before, after, triangles);
+		default: return NULL;
+	}
+}
+
+//finds the index list of a face element the specialized loop can decode
+static const PlyProperty* faceLayout(const PlyElement &element, size_t &before, size_t &after)
+{
+	const PlyProperty* list = NULL;
+	before = after = 0;
+	for (size_t i = 0; i < element.properties.size(); i++)
+	{
+		const PlyProperty &property = element.properties[i];
+		if (isIndexList(property) && list == NULL)
+			list = &property;
+		else if (property.countType != PLY_NONE)
+			return NULL;
+		else (list ? after : before) += plyTypeSize[property.type];
+	}
+	if (list == NULL || list->type == PLY_INT8 || list->type == PLY_UINT8 || list->type >= PLY_FLOAT32)
+		return NULL;
+	return list;
+}
+
+template<bool swap> static bool parseBinaryBody(const char* p, const char* end, const std::vector<PlyElement> &elements, PlyData &out)
+{
+	bool vertexDone = false, faceDone = false;
+	for (size_t i = 0; i < elements.size(); i++)
+	{
+		const PlyElement &element = elements[i];
+		bool isVertex = !vertexDone && element.name == "vertex";
+		bool isFace = !faceDone && element.name == "face";
+		if (isVertex)
+		{
+			//every vertex takes at least a byte, don't trust a count the file can't hold
+			if (element.count > (size_t)(end - p))
+				return false;
+			prepareVertices(element, out);
+			vertexDone = true;
+		}
+		if (isFace)
+		{
+			out.triangles.reserve(std::min(element.count, (size_t)(end - p)));
+			faceDone = true;
+		}
+
+		size_t before, after;
+		const PlyProperty* list;
+		const char* next;
+		if (isVertex && isFixedSize(element))
+			next = decodeVertices<swap>(p, end, element, out);
+		else if (isFace && (list = faceLayout(element, before, after)) != NULL)
+			next = decodeFaces<swap>(*list, p, end, element.count, before, after, out.triangles);
+		else if (!isVertex && !isFace && isFixedSize(element))
+		{
+			size_t stride = 0;
+			for (size_t k = 0; k < element.properties.size(); k++)
+				stride += plyTypeSize[element.properties[k].type];
+			next = (stride && element.count > (size_t)(end - p) / stride) ? NULL : p + element.count * stride;
+		}
+		else
+		{
+			BinaryReader<swap> reader(p, end);
+			readElement(reader, element, out, isVertex, isFace);
+			next = reader.failed ? NULL : reader.p;
+		}
+
+		if (next == NULL)
+			return false;
+		p = next;
+	}
+	return true;
+}
+
+static bool parseAsciiBody(const char* p, const char* end, const std::vector<PlyElement> &elements, PlyData &out)
+{
+	AsciiReader reader(p, end);
+	bool vertexDone = false, faceDone = false;
+	for (size_t i = 0; i < elements.size() && !reader.failed; i++)
+	{
+		const PlyElement &element = elements[i];
+		bool isVertex = !vertexDone && element.name == "vertex";
+		bool isFace = !faceDone && element.name == "face";
+		if (isVertex)
+		{
+			if (element.count > (size_t)(end - reader.p))
+				return false;
+			prepareVertices(element, out);
+			vertexDone = true;
+		}
+		faceDone = faceDone || isFace;
+		readElement(reader, element, out, isVertex, isFace);
+	}
+	return !reader.failed;
+}
+
+bool parsePLY(const char* begin, const char* end, PlyData &out)
+{
+	PlyFormat format = PLY_ASCII;
+	std::vector<PlyElement> elements;
+	const char* body = NULL;
+	if (!parseHeader(begin, end, format, elements, body))
+		return false;
+
+	bool ok;
+	if (format == PLY_ASCII)
+		ok = parseAsciiBody(body, end, elements, out);
+	else if (format == PLY_BINARY_LE)
+		ok = parseBinaryBody<false>(body, end, elements, out);
+	else ok = parseBinaryBody<true>(body, end, elements, out);
+	if (!ok)
+		return false;
+
+	//drop the faces pointing past the vertices, the faces may come before the vertices so it is done at the end
+	if (!fitsMeshIndex(out.positions.size()) || !fitsMeshIndex(out.triangles.size()))
+		return false;
+	MeshIndex numVertices = out.positions.size();
+	size_t kept = 0;
+	for (size_t t = 0; t < out.triangles.size(); t++)
+	{
+		const Triangle &tri = out.triangles[t];
+		if (tri.i < numVertices && tri.j < numVertices && tri.k < numVertices)
+			out.triangles[kept++] = tri;
+	}
+	out.skipped = out.triangles.size() - kept;
+	out.triangles.erase(out.triangles.begin() + kept, out.triangles.end());
+	return true;
+}
+
+bool writePLY(const char* filename, const MeshData &mesh, bool binary)
+{
+	MeshIndex numVertices = mesh.indexed_positions.size();
+	bool hasNormals = mesh.indexed_normalsFinal.size() == numVertices && numVertices;
+	bool hasUvs = mesh.indexed_uvsFinal.size() == numVertices && numVertices;
+
+	std::vector<MeshIndex> remap;
+	MeshIndex usedVertices = mesh.remapUsedVertices(remap);
+	MeshIndex liveTriangles = 0;
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+		if (mesh.isLiveTriangle(mesh.triangles[t]))
+			liveTriangles++;
+
+	//the face lists are written as int
+	if (usedVertices > (MeshIndex)INT32_MAX)
+	{
+		std::cerr << "Too many vertices for a PLY file: " << filename << std::endl;
+		return false;
+	}
+
+	FILE* f = fopen(filename, "wb");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << filename << std::endl;
+		return false;
+	}
+
+	//binary files are written from memory as they are, the machines we build for are little endian
+	std::string header = std::string("ply\nformat ") + (binary ? "binary_little_endian" : "ascii") + " 1.0\n";
+	header += "element vertex " + std::to_string(usedVertices) + "\n";
+	header += "property float x\nproperty float y\nproperty float z\n";
+	if (hasNormals)
+		header += "property float nx\nproperty float ny\nproperty float nz\n";
+	if (hasUvs)
+		header += "property float s\nproperty float t\n";
+	header += "element face " + std::to_string(liveTriangles) + "\n";
+	header += "property list uchar int vertex_indices\nend_header\n";
+
+	BufferedFile out(f);
+	out.write(header.data(), header.size());
+
+	for (MeshIndex v = 0; v < numVertices; v++)
+	{
+		if (!remap[v])
+			continue;
+		float values[NUM_SLOTS];
+		int n = 0;
+		for (int k = 0; k < 3; k++)
+			values[n++] = mesh.indexed_positions[v].v[k];
+		if (hasNormals)
+			for (int k = 0; k < 3; k++)
+				values[n++] = mesh.indexed_normalsFinal[v].v[k];
+		if (hasUvs)
+			for (int k = 0; k < 2; k++)
+				values[n++] = mesh.indexed_uvsFinal[v].value[k];
+
+		if (binary)
+		{
+			out.write(values, n * sizeof(float));
+			continue;
+		}
+		char* p = out.reserve(PLY_MAX_LINE);
+		for (int k = 0; k < n; k++)
+		{
+			if (k)
+				*p++ = ' ';
+			p = formatFloat(p, values[k]);
+		}
+		*p++ = '\n';
+		out.commit(p);
+	}
+
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		if (!mesh.isLiveTriangle(tri))
+			continue;
+		const int32_t corners[3] = { (int32_t)remap[tri.i] - 1, (int32_t)remap[tri.j] - 1, (int32_t)remap[tri.k] - 1 };
+
+		if (binary)
+		{
+			char record[1 + sizeof(corners)];
+			record[0] = 3;
+			memcpy(record + 1, corners, sizeof(corners));
+			out.write(record, sizeof(record));
+			continue;
+		}
+		char* p = out.reserve(PLY_MAX_LINE);
+		*p++ = '3';
+		for (int k = 0; k < 3; k++)
+		{
+			*p++ = ' ';
+			p = formatUInt(p, (unsigned int)corners[k]);
+		}
+		*p++ = '\n';
+		out.commit(p);
+	}
+
+	bool ok = out.flush();
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		std::cerr << "Error writing file: " << filename << std::endl;
+	return ok;
+}
@@ -0,0 +1,171 @@
+#include "stlfile.h"
+#include "meshdata.h"
+#include "vertexwelder.h"
+#include "textscan.h"
+#include "bufferedfile.h"
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#define STL_HEADER_SIZE 80
+#define STL_RECORD_SIZE 50 //normal, three corners (12 floats) and a 16 bit attribute
+
+//false once the vertices no longer fit in MeshIndex
+static bool addTriangle(VertexWelder &welder, const Vector3* corners, StlData &out)
+{
+	if (!fitsMeshIndex(out.positions.size() + 3))
+		return false;
+	MeshIndex a = welder.add(corners[0]);
+	MeshIndex b = welder.add(corners[1]);
+	MeshIndex c = welder.add(corners[2]);
+	if (a == b || b == c || c == a)
+	{
+		out.skipped++;
+		return true;
+	}
+	out.triangles.push_back(Triangle(a, b, c));
+	return true;
+}
+
+static bool parseBinarySTL(const char* p, uint32_t count, StlData &out)
+{
+	VertexWelder welder(out.positions);
+	out.triangles.reserve(count);
+	p += STL_HEADER_SIZE + 4;
+	for (uint32_t t = 0; t < count; t++, p += STL_RECORD_SIZE)
+	{
+		Vector3 corners[3];
+		for (int k = 0; k < 3; k++)
+			memcpy(corners[k].v, p + 12 + k * 12, 12);
+		if (!addTriangle(welder, corners, out))
+			return false;
+	}
+	return true;
+}
+
+static const char* nextWord(const char* p, const char* end, const char* &word, size_t &length)
+{
+	while (p < end && (isBlank(*p) || isEndOfLine(*p))) p++;
+	word = p;
+	p = skipToken(p, end);
+	length = p - word;
+	return p;
+}
+
+//solid / facet normal / outer loop / vertex x y z (three times) / endloop / endfacet / endsolid
+static bool parseAsciiSTL(const char* p, const char* end, StlData &out)
+{
+	VertexWelder welder(out.positions);
+	Vector3 corners[3];
+	int corner = 0;
+	while (p < end)
+	{
+		const char* word;
+		size_t length;
+		p = nextWord(p, end, word, length);
+		if (length == 6 && memcmp(word, "vertex", 6) == 0)
+		{
+			if (corner == 3)
+				return false;
+			Vector3 &v = corners[corner++];
+			for (int k = 0; k < 3; k++)
+			{
+				p = skipBlanks(p, end);
+				const char* after = scanFloat(p, end, v.v[k]);
+				if (after == p)
+					return false;
+				p = after;
+			}
+		}
+		else if (length == 7 && memcmp(word, "endloop", 7) == 0)
+		{
+			if (corner != 3 || !addTriangle(welder, corners, out))
+				return false;
+			corner = 0;
+		}
+		else if (length == 5 && memcmp(word, "facet", 5) == 0)
+			p = skipLine(p, end); //the normal
+		else if (length == 5 && memcmp(word, "solid", 5) == 0)
+			p = skipLine(p, end); //the name
+	}
+	return corner == 0;
+}
+
+bool parseSTL(const char* begin, const char* end, StlData &out)
+{
+	size_t size = end - begin;
+
+	//binary files may also start with "solid", trust the triangle count when it matches the size
+	uint32_t count = 0;
+	if (size >= STL_HEADER_SIZE + 4)
+		memcpy(&count, begin + STL_HEADER_SIZE, 4);
+	bool binary = size >= STL_HEADER_SIZE + 4 && (size - STL_HEADER_SIZE - 4) / STL_RECORD_SIZE == count;
+	if (binary)
+		return parseBinarySTL(begin, count, out);
+
+	const char* p = skipBlanks(begin, end);
+	if (end - p >= 5 && memcmp(p, "solid", 5) == 0)
+		return parseAsciiSTL(p, end, out);
+	return false;
+}
+
+bool writeSTL(const char* filename, const MeshData &mesh)
+{
+	size_t liveTriangles = 0;
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+		if (mesh.isLiveTriangle(mesh.triangles[t]))
+			liveTriangles++;
+
+	//the count in the header is 32 bit
+	if (liveTriangles > UINT32_MAX)
+	{
+		std::cerr << "Too many triangles for an STL file: " << filename << std::endl;
+		return false;
+	}
+	uint32_t count = (uint32_t)liveTriangles;
+
+	FILE* f = fopen(filename, "wb");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << filename << std::endl;
+		return false;
+	}
+
+	//written from memory as it is, the machines we build for are little endian like the format
+	char header[STL_HEADER_SIZE + 4];
+	memset(header, 0, sizeof(header));
+	strcpy(header, "Surface-Simplification");
+	memcpy(header + STL_HEADER_SIZE, &count, 4);
+
+	BufferedFile out(f);
+	out.write(header, sizeof(header));
+
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		if (!mesh.isLiveTriangle(tri))
+			continue;
+		const Vector3 &a = mesh.indexed_positions[tri.i];
+		const Vector3 &b = mesh.indexed_positions[tri.j];
+		const Vector3 &c = mesh.indexed_positions[tri.k];
+		Vector3 normal = (b - a).cross(c - a);
+		if (normal.length() > 0)
+			normal.normalize();
+
+		char record[STL_RECORD_SIZE];
+		memcpy(record, normal.v, 12);
+		memcpy(record + 12, a.v, 12);
+		memcpy(record + 24, b.v, 12);
+		memcpy(record + 36, c.v, 12);
+		record[48] = record[49] = 0;
+		out.write(record, STL_RECORD_SIZE);
+	}
+
+	bool ok = out.flush();
+	ok = (fclose(f) == 0) && ok;
+	if (!ok)
+		std::cerr << "Error writing file: " << filename << std::endl;
+	return ok;
+}
@@ -0,0 +1,69 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+{
+	running = 0;
+	stopping = false;
+
+	if (numThreads == 0)
+		numThreads = std::thread::hardware_concurrency();
+	if (numThreads == 0)
+		numThreads = 1;
+
+	for (unsigned int i = 0; i < numThreads; i++)
+		workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	jobAvailable.notify_all();
+	for (unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void ThreadPool::enqueue(const std::function<void()> &job)
+{
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		jobs.push_back(job);
+	}
+	jobAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!jobs.empty() || running > 0)
+		jobsDone.wait(lock);
+}
+
+void ThreadPool::workerLoop()
+{
+	while (1)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!stopping && jobs.empty())
+				jobAvailable.wait(lock);
+			if (jobs.empty()) //stopping and nothing left to do
+				return;
+			job = jobs.front();
+			jobs.pop_front();
+			running++;
+		}
+
+		job();
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			running--;
+			if (jobs.empty() && running == 0)
+				jobsDone.notify_all();
+		}
+	}
+}
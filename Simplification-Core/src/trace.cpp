@@ -0,0 +1,145 @@
+#include "trace.h"
+
+#ifdef SIMPLIFICATION_TRACE
+
+#include <vector>
+#include <string>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+struct TraceEvent
+{
+	const char* name;
+	char phase;			//'X' a phase with its duration, 'C' a counter value
+	long long ts;		//microseconds since the program started
+	long long dur;
+	unsigned int tid;
+	unsigned long long value;
+};
+
+static std::mutex s_mutex;
+static std::vector<TraceEvent> s_events;
+static std::atomic<bool> s_recording(false);
+static std::atomic<TraceCounter*> s_counters(nullptr);
+static std::atomic<unsigned int> s_threads(0);
+static const std::chrono::steady_clock::time_point s_epoch = std::chrono::steady_clock::now();
+
+static long long now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_epoch).count();
+}
+
+//small numbers read better in the viewer than the system thread ids
+static unsigned int threadIndex()
+{
+	thread_local unsigned int index = ++s_threads;
+	return index;
+}
+
+TraceCounter::TraceCounter(const char* name) : name(name), value(0)
+{
+	next = s_counters.load();
+	while (!s_counters.compare_exchange_weak(next, this))
+		;
+}
+
+TraceScope::TraceScope(const char* name) : name(name)
+{
+	start = s_recording.load(std::memory_order_relaxed) ? now() : -1;
+}
+
+TraceScope::~TraceScope()
+{
+	if (start < 0 || !s_recording.load(std::memory_order_relaxed))
+		return;
+	TraceEvent e = { name, 'X', start, now() - start, threadIndex(), 0 };
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_events.push_back(e);
+}
+
+void traceSampleCounters()
+{
+	if (!s_recording.load(std::memory_order_relaxed))
+		return;
+
+	//one value per name
+	std::map<std::string, unsigned long long> totals;
+	for (TraceCounter* c = s_counters.load(); c != NULL; c = c->next)
+		totals[c->name] += c->value.load(std::memory_order_relaxed);
+
+	long long ts = now();
+	std::lock_guard<std::mutex> lock(s_mutex);
+	for (TraceCounter* c = s_counters.load(); c != NULL; c = c->next)
+	{
+		std::map<std::string, unsigned long long>::iterator it = totals.find(c->name);
+		if (it == totals.end())
+			continue;
+		TraceEvent e = { c->name, 'C', ts, 0, 0, it->second };
+		s_events.push_back(e);
+		totals.erase(it);
+	}
+}
+
+bool traceStart()
+{
+	for (TraceCounter* c = s_counters.load(); c != NULL; c = c->next)
+		c->value.store(0);
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_events.clear();
+	}
+	s_recording = true;
+	traceSampleCounters();
+	return true;
+}
+
+bool traceWrite(const char* filename)
+{
+	traceSampleCounters();
+	s_recording = false;
+
+	FILE* f = fopen(filename, "w");
+	if (f == NULL)
+	{
+		std::cerr << "Can't write file: " << filename << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (size_t i = 0; i < s_events.size(); i++)
+	{
+		const TraceEvent &e = s_events[i];
+		if (e.phase == 'X')
+			fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":1,\"tid\":%u}", e.name, e.ts, e.dur, e.tid);
+		else fprintf(f, "{\"name\":\"%s\",\"ph\":\"C\",\"ts\":%lld,\"pid\":1,\"args\":{\"value\":%llu}}", e.name, e.ts, e.value);
+		fprintf(f, i + 1 < s_events.size() ? ",\n" : "\n");
+	}
+	fprintf(f, "]}\n");
+
+	bool ok = !ferror(f);
+	if (fclose(f) != 0 || !ok)
+	{
+		std::cerr << "Error writing file: " << filename << std::endl;
+		return false;
+	}
+	return true;
+}
+
+#else
+
+bool traceStart()
+{
+	return false;
+}
+
+bool traceWrite(const char*)
+{
+	return false;
+}
+
+#endif
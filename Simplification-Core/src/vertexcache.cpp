@@ -0,0 +1,229 @@
+#include "vertexcache.h"
+#include "meshdata.h"
+#include "trace.h"
+#include <cmath>
+
+#define FORSYTH_CACHE_SIZE 32	//LRU entries the scores model
+#define FORSYTH_MAX_VALENCE 32	//valence scores past this are all the same
+
+float computeACMR(const MeshData &mesh, unsigned int cacheSize)
+{
+	//a vertex is in the FIFO if fewer than cacheSize misses happened since it was loaded
+	std::vector<size_t> loadedAt(mesh.indexed_positions.size(), 0);
+	size_t misses = 0, live = 0, time = cacheSize + 1;
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		if (!mesh.isLiveTriangle(tri))
+			continue;
+		live++;
+		const MeshIndex corners[3] = { tri.i, tri.j, tri.k };
+		for (int k = 0; k < 3; k++)
+		{
+			if (time - loadedAt[corners[k]] > cacheSize)
+			{
+				loadedAt[corners[k]] = time++;
+				misses++;
+			}
+		}
+	}
+	return live ? (float)misses / live : 0;
+}
+
+//score tables from Forsyth's paper: the last three vertices used score the same so the strip direction is free,
+//older ones fade out, and vertices with few triangles left get a boost so they are finished and evicted
+struct ForsythScores
+{
+	float cache[FORSYTH_CACHE_SIZE];
+	float valence[FORSYTH_MAX_VALENCE + 1];
+
+	ForsythScores()
+	{
+		for (int i = 0; i < FORSYTH_CACHE_SIZE; i++)
+			cache[i] = i < 3 ? 0.75f : powf(1.0f - (i - 3) / (float)(FORSYTH_CACHE_SIZE - 3), 1.5f);
+		valence[0] = 0;
+		for (int i = 1; i <= FORSYTH_MAX_VALENCE; i++)
+			valence[i] = 2.0f / sqrtf((float)i);
+	}
+};
+
+static inline float vertexScore(const ForsythScores &scores, int cachePosition, MeshIndex remaining)
+{
+	if (remaining == 0)
+		return -1; //no triangle left to draw with it
+	float score = cachePosition >= 0 ? scores.cache[cachePosition] : 0;
+	return score + scores.valence[remaining < FORSYTH_MAX_VALENCE ? remaining : FORSYTH_MAX_VALENCE];
+}
+
+void optimizeVertexCache(MeshData &mesh)
+{
+	TRACE_SCOPE("vertex cache");
+	//built once by the first call, a local static is safe when meshes are optimized on several threads
+	static const ForsythScores s_scores;
+
+	std::vector<Triangle> triangles;
+	triangles.reserve(mesh.triangles.size());
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+		if (mesh.isLiveTriangle(mesh.triangles[t]))
+			triangles.push_back(mesh.triangles[t]);
+
+	//the triangles not drawn yet of every vertex are the first remaining[v] of its adjacency
+	size_t numVertices = mesh.indexed_positions.size();
+	std::vector<MeshIndex> remaining(numVertices, 0);
+	for (size_t t = 0; t < triangles.size(); t++)
+	{
+		remaining[triangles[t].i]++;
+		remaining[triangles[t].j]++;
+		remaining[triangles[t].k]++;
+	}
+	std::vector<size_t> offsets(numVertices + 1, 0);
+	for (size_t v = 0; v < numVertices; v++)
+		offsets[v + 1] = offsets[v] + remaining[v];
+	std::vector<MeshIndex> adjacency(offsets[numVertices]);
+	std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+	for (size_t t = 0; t < triangles.size(); t++)
+	{
+		adjacency[fill[triangles[t].i]++] = (MeshIndex)t;
+		adjacency[fill[triangles[t].j]++] = (MeshIndex)t;
+		adjacency[fill[triangles[t].k]++] = (MeshIndex)t;
+	}
+
+	std::vector<int> cachePosition(numVertices, -1);
+	std::vector<float> score(numVertices);
+	for (size_t v = 0; v < numVertices; v++)
+		score[v] = vertexScore(s_scores, -1, remaining[v]);
+	std::vector<float> triangleScore(triangles.size());
+	for (size_t t = 0; t < triangles.size(); t++)
+		triangleScore[t] = score[triangles[t].i] + score[triangles[t].j] + score[triangles[t].k];
+	std::vector<bool> emitted(triangles.size(), false);
+
+	//three extra slots hold what the new triangle pushes out
+	MeshIndex cache[FORSYTH_CACHE_SIZE + 3];
+	int cacheSize = 0;
+
+	std::vector<Triangle> ordered;
+	ordered.reserve(triangles.size());
+	size_t cursor = 0; //fallback when the cache has nothing to offer, in input order
+	size_t best = 0;
+	while (ordered.size() < triangles.size())
+	{
+		const Triangle tri = triangles[best];
+		ordered.push_back(tri);
+		emitted[best] = true;
+
+		const MeshIndex corners[3] = { tri.i, tri.j, tri.k };
+		for (int k = 0; k < 3; k++)
+		{
+			MeshIndex v = corners[k];
+			MeshIndex* list = &adjacency[offsets[v]];
+			for (MeshIndex a = 0; a < remaining[v]; a++)
+			{
+				if (list[a] == best)
+				{
+					list[a] = list[remaining[v] - 1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		//the corners go to the front of the LRU cache, the rest keeps its order
+		MeshIndex next[FORSYTH_CACHE_SIZE + 3];
+		int nextSize = 0;
+		for (int k = 0; k < 3; k++)
+			next[nextSize++] = corners[k];
+		for (int c = 0; c < cacheSize; c++)
+			if (cache[c] != corners[0] && cache[c] != corners[1] && cache[c] != corners[2])
+				next[nextSize++] = cache[c];
+		for (int c = FORSYTH_CACHE_SIZE; c < nextSize; c++)
+			cachePosition[next[c]] = -1;
+		cacheSize = nextSize < FORSYTH_CACHE_SIZE ? nextSize : FORSYTH_CACHE_SIZE;
+		for (int c = 0; c < cacheSize; c++)
+		{
+			cache[c] = next[c];
+			cachePosition[next[c]] = c;
+		}
+
+		//new scores for everything that moved, then the best triangle touching the cache
+		for (int c = 0; c < nextSize; c++)
+		{
+			MeshIndex v = next[c];
+			float updated = vertexScore(s_scores, cachePosition[v], remaining[v]);
+			float delta = updated - score[v];
+			score[v] = updated;
+			for (MeshIndex a = 0; a < remaining[v]; a++)
+				triangleScore[adjacency[offsets[v] + a]] += delta;
+		}
+		float bestScore = -1;
+		bool found = false;
+		for (int c = 0; c < cacheSize; c++)
+		{
+			MeshIndex v = cache[c];
+			for (MeshIndex a = 0; a < remaining[v]; a++)
+			{
+				MeshIndex t = adjacency[offsets[v] + a];
+				if (triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					best = t;
+					found = true;
+				}
+			}
+		}
+		if (!found)
+		{
+			while (cursor < triangles.size() && emitted[cursor])
+				cursor++;
+			best = cursor;
+		}
+	}
+
+	mesh.dropTopology();
+	mesh.triangles.swap(ordered);
+	mesh.dirtyTriangles = true;
+}
+
+template<class T> static void permute(std::vector<T> &values, const std::vector<MeshIndex> &remap, size_t used)
+{
+	std::vector<T> permuted(used);
+	for (size_t v = 0; v < remap.size(); v++)
+		if (remap[v])
+			permuted[remap[v] - 1] = values[v];
+	values.swap(permuted);
+}
+
+void optimizeVertexFetch(MeshData &mesh)
+{
+	TRACE_SCOPE("vertex fetch");
+	//remap[v] is the new index + 1, 0 until a triangle uses it
+	size_t numVertices = mesh.indexed_positions.size();
+	std::vector<MeshIndex> remap(numVertices, 0);
+	std::vector<Triangle> triangles;
+	triangles.reserve(mesh.triangles.size());
+	MeshIndex used = 0;
+	for (size_t t = 0; t < mesh.triangles.size(); t++)
+	{
+		const Triangle &tri = mesh.triangles[t];
+		if (!mesh.isLiveTriangle(tri))
+			continue;
+		MeshIndex corners[3] = { tri.i, tri.j, tri.k };
+		for (int k = 0; k < 3; k++)
+		{
+			if (!remap[corners[k]])
+				remap[corners[k]] = ++used;
+			corners[k] = remap[corners[k]] - 1;
+		}
+		triangles.push_back(Triangle(corners[0], corners[1], corners[2]));
+	}
+
+	permute(mesh.indexed_positions, remap, used);
+	if (mesh.indexed_normalsFinal.size() == numVertices)
+		permute(mesh.indexed_normalsFinal, remap, used);
+	if (mesh.indexed_uvsFinal.size() == numVertices)
+		permute(mesh.indexed_uvsFinal, remap, used);
+
+	mesh.dropTopology();
+	mesh.triangles.swap(triangles);
+	mesh.dirtyVertices = true;
+	mesh.dirtyTriangles = true;
+}
@@ -0,0 +1,65 @@
+#include "vertexwelder.h"
+#include <cstring>
+#include <stdint.h>
+
+#define WELDER_EMPTY MESHINDEX_MAX
+#define WELDER_INITIAL_SIZE 1024
+
+VertexWelder::VertexWelder(std::vector<Vector3> &positions) : positions(positions)
+{
+	size_t size = WELDER_INITIAL_SIZE;
+	while (size < positions.size() * 2)
+		size *= 2;
+	this->rehash(size);
+}
+
+static inline uint32_t floatBits(float f)
+{
+	if (f == 0)
+		f = 0; //-0 hashes as 0
+	uint32_t bits;
+	memcpy(&bits, &f, 4);
+	return bits;
+}
+
+size_t VertexWelder::slot(const Vector3 &p) const
+{
+	uint64_t h = floatBits(p.x) * 0x9E3779B185EBCA87ULL;
+	h = (h ^ floatBits(p.y)) * 0xC2B2AE3D27D4EB4FULL;
+	h = (h ^ floatBits(p.z)) * 0x9E3779B185EBCA87ULL;
+	return (size_t)(h ^ (h >> 32)) & mask;
+}
+
+MeshIndex VertexWelder::add(const Vector3 &p)
+{
+	size_t s = this->slot(p);
+	while (table[s] != WELDER_EMPTY)
+	{
+		const Vector3 &q = positions[table[s]];
+		if (q.x == p.x && q.y == p.y && q.z == p.z)
+			return table[s];
+		s = (s + 1) & mask;
+	}
+
+	MeshIndex index = positions.size();
+	positions.push_back(p);
+	table[s] = index;
+
+	//keep the table at most half full so probes stay short
+	if (positions.size() * 2 > table.size())
+		this->rehash(table.size() * 2);
+	return index;
+}
+
+void VertexWelder::rehash(size_t size)
+{
+	table.assign(size, WELDER_EMPTY);
+	mask = table.size() - 1;
+	for (MeshIndex i = 0; i < positions.size(); i++)
+	{
+		size_t s = this->slot(positions[i]);
+		while (table[s] != WELDER_EMPTY)
+			s = (s + 1) & mask;
+		table[s] = i;
+	}
+}
@@ -0,0 +1,28 @@
+/*  Checks of the core library, run by Simplification-Tests.
+	 + A test is a function that reports what is wrong through CHECK, it doesn't stop at the first failure
+	 + main runs every test and exits with 1 if any check failed
+	 + Files are written next to the executable and removed afterwards
+*/
+
+#ifndef TESTS_H
+#define TESTS_H
+
+#include <iostream>
+
+extern unsigned int g_failedChecks;
+
+#define CHECK(condition) do { if (!(condition)) { g_failedChecks++; \
+	std::cerr << __FILE__ << ":" << __LINE__ << " failed: " << #condition << std::endl; } } while (0)
+
+//meshcachetests.cpp
+void testMeshCacheRoundTrip();
+void testMeshCacheTamperedAdjacency();
+
+//textformattests.cpp
+void testFormatFloatRoundTrip();
+void testTextWritersRoundTrip();
+
+//vertexcachetests.cpp
+void testVertexCacheConcurrent();
+
+#endif
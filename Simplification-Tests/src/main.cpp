@@ -0,0 +1,47 @@
+/*  Checks of the core library (see tests.h), prints a line per test and exits with 1 if any failed.
+	simplify-tests [name]... runs only the tests with those names
+*/
+
+#include "tests.h"
+
+#include <string>
+#include <cstring>
+
+unsigned int g_failedChecks = 0;
+
+struct Test
+{
+	const char* name;
+	void (*run)();
+};
+
+static const Test s_tests[] = {
+	{ "meshcache round trip", testMeshCacheRoundTrip },
+	{ "meshcache tampered adjacency", testMeshCacheTamperedAdjacency },
+	{ "formatFloat round trip", testFormatFloatRoundTrip },
+	{ "text writers round trip", testTextWritersRoundTrip },
+	{ "vertex cache on two threads", testVertexCacheConcurrent }
+};
+
+int main(int argc, char **argv)
+{
+	unsigned int run = 0, failedTests = 0;
+	for (size_t t = 0; t < sizeof(s_tests) / sizeof(s_tests[0]); t++)
+	{
+		bool selected = argc < 2;
+		for (int i = 1; i < argc && !selected; i++)
+			selected = strcmp(argv[i], s_tests[t].name) == 0;
+		if (!selected)
+			continue;
+
+		unsigned int before = g_failedChecks;
+		s_tests[t].run();
+		run++;
+		bool ok = g_failedChecks == before;
+		if (!ok)
+			failedTests++;
+		std::cout << (ok ? "ok    " : "FAIL  ") << s_tests[t].name << std::endl;
+	}
+	std::cout << run << " tests, " << failedTests << " failed" << std::endl;
+	return failedTests ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#include "tests.h"
+#include "meshdata.h"
+#include "meshcache.h"
+#include "meshgenerator.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define CACHE_FILE "tests_meshcache.tmp"
+#define SOURCE_FILE "tests_meshcache_source.tmp"
+
+static bool readFile(const char* filename, std::vector<unsigned char> &data)
+{
+	FILE* f = fopen(filename, "rb");
+	if (f == NULL)
+		return false;
+	fseek(f, 0, SEEK_END);
+	data.resize((size_t)ftell(f));
+	fseek(f, 0, SEEK_SET);
+	bool ok = data.empty() || fread(&data[0], 1, data.size(), f) == data.size();
+	fclose(f);
+	return ok;
+}
+
+static bool writeFile(const char* filename, const std::vector<unsigned char> &data)
+{
+	FILE* f = fopen(filename, "wb");
+	if (f == NULL)
+		return false;
+	bool ok = fwrite(&data[0], 1, data.size(), f) == data.size();
+	return (fclose(f) == 0) && ok;
+}
+
+//a sphere with its adjacency, written to CACHE_FILE. The cache records its source, any file does for that
+static bool writeSphereCache(MeshData &mesh)
+{
+	mesh.verbose = false;
+	if (!generateMesh(SHAPE_SPHERE, 2000, 1, mesh))
+		return false;
+	std::vector<unsigned char> source(16, 'x');
+	bool ok = writeFile(SOURCE_FILE, source) && saveMeshCache(CACHE_FILE, mesh, SOURCE_FILE, MESHCACHE_ADJACENCY);
+	remove(SOURCE_FILE);
+	return ok;
+}
+
+void testMeshCacheRoundTrip()
+{
+	MeshData mesh, loaded;
+	loaded.verbose = false;
+	CHECK(writeSphereCache(mesh));
+	CHECK(loadMeshCache(CACHE_FILE, loaded));
+	CHECK(loaded.indexed_positions.size() == mesh.indexed_positions.size());
+	CHECK(loaded.triangles.size() == mesh.triangles.size());
+	CHECK(loaded.adjacencyOffsets == mesh.adjacencyOffsets);
+	CHECK(loaded.adjacencyTriangles == mesh.adjacencyTriangles);
+	remove(CACHE_FILE);
+}
+
+void testMeshCacheTamperedAdjacency()
+{
+	MeshData mesh;
+	std::vector<unsigned char> data;
+	CHECK(writeSphereCache(mesh));
+	CHECK(readFile(CACHE_FILE, data));
+	remove(CACHE_FILE);
+	if (data.size() < sizeof(MeshCacheHeader))
+		return;
+
+	MeshCacheHeader header;
+	memcpy(&header, &data[0], sizeof(header));
+	const MeshCacheSection* offsets = NULL;
+	for (uint32_t i = 0; i < header.numSections && i < MESHCACHE_MAX_SECTIONS; i++)
+		if (header.sections[i].type == SECTION_ADJACENCY_OFFSETS)
+			offsets = &header.sections[i];
+	CHECK(offsets != NULL && offsets->count > 3);
+	if (offsets == NULL || offsets->count <= 3)
+		return;
+
+	//an offset past the next one, the first and last stay as they were so only the order gives it away
+	MeshIndex* values = (MeshIndex*)&data[(size_t)offsets->offset];
+	CHECK(values[1] < values[2]);
+	values[1] = values[2] + 1;
+	CHECK(writeFile(CACHE_FILE, data));
+
+	MeshData loaded;
+	loaded.verbose = false;
+	CHECK(!loadMeshCache(CACHE_FILE, loaded));
+	CHECK(loaded.indexed_positions.empty() && loaded.adjacencyOffsets.empty());
+	remove(CACHE_FILE);
+}
@@ -0,0 +1,61 @@
+#include "tests.h"
+#include "meshdata.h"
+#include "textformat.h"
+
+#include <cstdio>
+#include <cstring>
+
+#define TEXT_FILE_OBJ "tests_textformat.obj"
+#define TEXT_FILE_PLY "tests_textformat.ply"
+
+//values the old 6 decimals lost: under the last decimal, past the float precision and the fraction of a large one
+static const float s_values[] = { 1e-7f, 123456.789f, -3.14159274f, 0.1f, 16777215.0f, -2.5e-12f, 3.0e20f, 1.0f / 3.0f, 0.000123456789f };
+#define NUM_VALUES (sizeof(s_values) / sizeof(s_values[0]))
+
+static bool sameBits(float a, float b)
+{
+	return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+//one triangle per three values, each value in every coordinate
+static void buildValueMesh(MeshData &mesh)
+{
+	mesh.verbose = false;
+	for (size_t i = 0; i < NUM_VALUES; i++)
+		mesh.indexed_positions.push_back(Vector3(s_values[i], s_values[(i + 1) % NUM_VALUES], s_values[(i + 2) % NUM_VALUES]));
+	for (MeshIndex t = 0; t + 2 < NUM_VALUES; t += 3)
+		mesh.triangles.push_back(Triangle(t, t + 1, t + 2));
+}
+
+static void checkReloaded(const MeshData &mesh, const char* filename)
+{
+	MeshData loaded;
+	loaded.verbose = false;
+	CHECK(loaded.load(filename));
+	CHECK(loaded.indexed_positions.size() == mesh.indexed_positions.size());
+	for (size_t v = 0; v < mesh.indexed_positions.size() && v < loaded.indexed_positions.size(); v++)
+		for (int k = 0; k < 3; k++)
+			CHECK(sameBits(loaded.indexed_positions[v].v[k], mesh.indexed_positions[v].v[k]));
+	remove(filename);
+}
+
+void testFormatFloatRoundTrip()
+{
+	for (size_t i = 0; i < NUM_VALUES; i++)
+	{
+		char text[64];
+		*formatFloat(text, s_values[i]) = 0;
+		float back = 0;
+		CHECK(sscanf(text, "%f", &back) == 1 && sameBits(back, s_values[i]));
+	}
+}
+
+void testTextWritersRoundTrip()
+{
+	MeshData mesh;
+	buildValueMesh(mesh);
+	CHECK(mesh.saveOBJ(TEXT_FILE_OBJ));
+	checkReloaded(mesh, TEXT_FILE_OBJ);
+	CHECK(mesh.savePLY(TEXT_FILE_PLY, false));
+	checkReloaded(mesh, TEXT_FILE_PLY);
+}
@@ -0,0 +1,43 @@
+#include "tests.h"
+#include "meshdata.h"
+#include "meshgenerator.h"
+#include "vertexcache.h"
+
+#include <thread>
+
+static bool sameTriangles(const MeshData &a, const MeshData &b)
+{
+	if (a.triangles.size() != b.triangles.size())
+		return false;
+	for (size_t t = 0; t < a.triangles.size(); t++)
+		if (a.triangles[t].i != b.triangles[t].i || a.triangles[t].j != b.triangles[t].j || a.triangles[t].k != b.triangles[t].k)
+			return false;
+	return true;
+}
+
+//the CLI optimizes its outputs on pool threads, the two runs have to give what each gives alone.
+//It runs before any other optimization so the threads are also the first to use the score tables
+void testVertexCacheConcurrent()
+{
+	MeshData sources[2];
+	sources[0].verbose = sources[1].verbose = false;
+	CHECK(generateMesh(SHAPE_TORUS, 20000, 1, sources[0]));
+	CHECK(generateMesh(SHAPE_SCAN, 20000, 2, sources[1]));
+
+	MeshData concurrent[2];
+	for (int i = 0; i < 2; i++)
+		sources[i].copyGeometry(concurrent[i]);
+	std::thread first([&]() { optimizeVertexCache(concurrent[0]); });
+	std::thread second([&]() { optimizeVertexCache(concurrent[1]); });
+	first.join();
+	second.join();
+
+	for (int i = 0; i < 2; i++)
+	{
+		MeshData alone;
+		sources[i].copyGeometry(alone);
+		optimizeVertexCache(alone);
+		CHECK(sameTriangles(concurrent[i], alone));
+		CHECK(computeACMR(alone) < computeACMR(sources[i]));
+	}
+}
@@ -1,68 +1,30 @@
 /*  by Javi Agenjo 2013 UPF  javi.agenjo@gmail.com
-	The Mesh contains the info about how to render a mesh and also how to parse it from a file.
+	The Mesh contains the info about how to render a mesh. The parsing and simplification lives in MeshData.
+	The geometry is kept in GPU buffers, only the arrays marked dirty in MeshData are uploaded again.
 */
 
 #ifndef MESH_H
 #define MESH_H
 
-#include <vector>
-#include "framework.h"
-#include <map>
-#include <queue>
+#include "meshdata.h"
 
-using namespace std;
-
-struct customVec3Comparator {
-	bool operator()(const Vector3& a, const Vector3& b) const 
-	{
-		if (a.x != b.x)
-			return (a.x < b.x);
-
-		if (a.y != b.y)
-			return (a.y < b.y);
-
-		return (a.z < b.z);
-	}
-};
-
-struct LessCost
-{
-	bool operator()(const Edge& a, const Edge& b) const
-	{
-		return a.cost < b.cost;
-	}
-};
-
-class Mesh
+class Mesh : public MeshData
 {
 public:
-	std::map<Vector3, vector<unsigned int>, customVec3Comparator> vertexTriangles;
-	std::map<Vector3, vector<unsigned int>, customVec3Comparator> vertexEdges;
-	vector<Edge> edges;
-
-	std::vector<Vector3> indexed_positions;
-	std::vector<Vector3> indexed_normals;
-	std::vector<Vector3> indexed_normalsFinal;
-	std::vector<Vector2> indexed_uvs;
-	std::vector<Triangle> triangles;
-
 	Mesh();
-	void clear();
+	~Mesh();
 	void render(const int &primitive);
+	void upload(); //sends the arrays that changed since the last upload to the GPU, render calls it
 
-	Matrix44 getTriangleMatrix(const unsigned int &tri);
-	Matrix44 getTriangleVectorMatrix(std::vector<unsigned int> triangles);
+private:
+	unsigned int vertexBuffer, normalBuffer, indexBuffer; //0 until the first upload
+	size_t normalCount; //normals in their buffer, they can arrive after the positions
 
-	void addEdge(const unsigned int &i, const unsigned int &j, const unsigned int &triangleIndex);
-	void updateEdges(const unsigned int &i);
-	int totalTriangles();
+	static bool s_ready; //used to initialize the buffer functions
+	static void init();
 
-	void computeAllCosts();
-	void computeCost(Edge *edge);
-	void edgeContraction(const unsigned &numTriang);
-	bool loadOBJ(const char* filename);
+	Mesh(const Mesh&);
+	Mesh& operator=(const Mesh&);
 };
 
-
-
-#endif
\ No newline at end of file
+#endif
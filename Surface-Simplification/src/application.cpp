@@ -4,12 +4,31 @@
 #include "camera.h"
 #include "mesh.h"
 #include "shader.h"
+#include "meshworker.h"
+#include "lodselector.h"
+#include "mathkernels.h"
+#include "bvh.h"
 
 Camera* camera = NULL;
 Mesh* mesh = NULL;
+MeshWorker* worker = NULL; //loads and simplifies off the render thread
+
+//LOD chain of the current mesh, drawn instead of it when enabled
+std::vector<Mesh*> lods;
+std::vector<float> lodRatios = { 1.0f, 0.5f, 0.25f, 0.125f, 0.0625f };
+LodSelector lodSelector;
+bool useLods = false;
+Vector3 lodCenter;
+float lodRadius = 0;
 Matrix44 model_matrix;
 Shader* phong = NULL;
 
+//picking with the mouse, the BVH is built on the first click on a mesh
+Mesh* drawnMesh = NULL; //the one rendered last
+TriangleBVH pickBVH;
+const Mesh* pickMesh = NULL; //the one pickBVH was built for, NULL when it has to be built again
+std::string pickText;
+
 float vel = 0.05;
 
 Application::Application(const char* caption, int width, int height)
@@ -31,6 +50,7 @@ Application::Application(const char* caption, int width, int height)
 void Application::init(void)
 {
 	std::cout << "initiating app..." << std::endl;
+	std::cout << "matrix kernels: " << g_mathKernels->name << std::endl;
 	
 	eye = Vector3(0, 20, 40);
 	specularColor = Vector3(0.5, 0.5, 0.5);
@@ -42,9 +62,10 @@ void Application::init(void)
 	camera->lookAt(eye, Vector3(0,10,0),Vector3(0,1,0));
 	camera->setPerspective(60,window_width / window_height,0.1,10000);
 
-	//then we load a mesh
+	//then we load a mesh, in the background so the window shows up at once
 	mesh = new Mesh();
-	mesh->loadOBJ("data/lee.obj");
+	worker = new MeshWorker();
+	worker->load("data/lee.obj");
 
 	//we load a shader
 	phong = new Shader();
@@ -55,6 +76,43 @@ void Application::init(void)
 //render one frame
 void Application::render(void)
 {
+	//pick up the mesh of a finished job, the chain of the old one is no longer valid
+	if (worker->takeResult(*mesh))
+	{
+		pickMesh = NULL;
+		pickText.clear();
+		for (size_t l = 0; l < lods.size(); l++)
+			delete lods[l];
+		lods.clear();
+		useLods = false;
+	}
+	std::vector<MeshData> chain;
+	if (worker->takeLODs(chain))
+	{
+		pickMesh = NULL;
+		pickText.clear();
+		for (size_t l = 0; l < chain.size(); l++)
+		{
+			lods.push_back(new Mesh());
+			lods.back()->swap(chain[l]);
+		}
+		boundingSphere(*lods[0], lodCenter, lodRadius);
+		//a mesh filling the window needs the full detail
+		lodSelector.fullDetailPixels = window_height;
+		lodSelector.setLevels(lodRatios);
+		useLods = true;
+	}
+
+	//the level that keeps the triangles as dense on screen as the full mesh filling the window
+	Mesh* drawn = mesh;
+	if (useLods && lods.size())
+	{
+		float scale = (float)model_matrix.rightVector().length();
+		float size = projectedSize(model_matrix * lodCenter, lodRadius * scale, camera->eye, camera->fov, window_height);
+		drawn = lods[lodSelector.select(size)];
+	}
+	drawnMesh = drawn;
+
 	// Clear the window and the depth buffer
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	glEnable( GL_DEPTH_TEST );
@@ -67,9 +125,20 @@ void Application::render(void)
 	//Render Text
 	std::string text;
 
-	int totalTriangles = mesh->totalTriangles();
+	MeshIndex totalTriangles = drawn->totalTriangles();
 
 	text = "Numero de triangulos:  " + to_string(totalTriangles);
+	if (drawn != mesh)
+		text += "   LOD " + to_string(lodSelector.getLevel());
+	if (pickText.size())
+		text += "   " + pickText;
+	if (worker->isBusy())
+	{
+		text += "   " + worker->getStatus();
+		float progress = worker->getProgress();
+		if (progress >= 0)
+			text += " " + to_string((int)(progress * 100)) + "%";
+	}
 	drawString(text.c_str());
 	
 	//Phong shader
@@ -83,7 +152,7 @@ void Application::render(void)
 	phong->setVector3("ambientColor", ambientColor);
 	phong->setVector3("diffuseColor", diffuseColor);
 	//render the data
-	mesh->render(GL_TRIANGLES);
+	drawn->render(GL_TRIANGLES);
 	//disable render
 	phong->disable();
 
@@ -180,13 +249,18 @@ void Application::onKeyPressed( SDL_KeyboardEvent event )
 	{
 		case SDLK_ESCAPE: exit(0); break; //ESC key, kill the app
 		case SDLK_m:
-			if (event.type == SDL_KEYUP) {
-				int triangles;
-				cout << "Number of triangles after contraction: " << endl;
-				cin >> triangles;
-				if (triangles > 0)
-					mesh->edgeContraction((unsigned)triangles);
-				else cout << "Input can't be negative" << endl;
+			//halves the triangles in the background, ignored while a job is running
+			if (event.type == SDL_KEYUP && mesh->triangles.size())
+				worker->simplify(*mesh, (MeshIndex)mesh->triangles.size() / 2);
+			break;
+		case SDLK_l:
+			//builds the LOD chain of the mesh in the background the first time, then switches it on and off
+			if (event.type == SDL_KEYUP)
+			{
+				if (lods.size())
+					useLods = !useLods;
+				else if (mesh->triangles.size())
+					worker->buildLODs(*mesh, lodRatios);
 			}
 			break;
 		case SDLK_z:
@@ -203,14 +277,12 @@ void Application::onKeyPressed( SDL_KeyboardEvent event )
 			break;
 		case SDLK_1:
 			if (event.type == SDL_KEYUP){
-				mesh->clear();
-				mesh->loadOBJ("data/lee.obj");
+				worker->load("data/lee.obj");
 			}
 			break;
 		case SDLK_2:
 			if (event.type == SDL_KEYUP){
-				mesh->clear();
-				mesh->loadOBJ("data/man.obj");
+				worker->load("data/man.obj");
 			}
 			break;
 	}
@@ -221,7 +293,33 @@ void Application::onMouseButtonDown( SDL_MouseButtonEvent event )
 {
 	if (event.button == SDL_BUTTON_LEFT) //left mouse pressed
 	{
+		//the triangle under the cursor, of the mesh or LOD drawn last
+		if (drawnMesh == NULL || drawnMesh->triangles.empty())
+			return;
+		if (pickMesh != drawnMesh)
+		{
+			pickBVH.build(*drawnMesh, 0);
+			pickMesh = drawnMesh;
+		}
+
+		//the cursor at the near and far planes, back to the space of the mesh
+		Matrix44 inverse = model_matrix * camera->getViewProjectionMatrix();
+		if (!inverse.inverse())
+			return;
+		float x = 2 * event.x / window_width - 1, y = 1 - 2 * event.y / window_height;
+		Vector4 nearPoint = multV4xM4(Vector4(x, y, -1, 1), inverse);
+		Vector4 farPoint = multV4xM4(Vector4(x, y, 1, 1), inverse);
+		DVector3 origin(nearPoint.x / nearPoint.w, nearPoint.y / nearPoint.w, nearPoint.z / nearPoint.w);
+		DVector3 end(farPoint.x / farPoint.w, farPoint.y / farPoint.w, farPoint.z / farPoint.w);
 
+		BVHRayHit hit;
+		if (pickBVH.intersectRay(origin, end - origin, 1, hit))
+		{
+			DVector3 point = origin + (end - origin) * hit.t;
+			pickText = "triangulo " + to_string(hit.triangle);
+			std::cout << "picked triangle " << hit.triangle << " at " << point.x << ", " << point.y << ", " << point.z << std::endl;
+		}
+		else pickText.clear();
 	}
 }
 
@@ -130,8 +130,8 @@ void Camera::updateProjectionMatrix()
 
 Matrix44 Camera::getViewProjectionMatrix()
 {
+	//updateProjectionMatrix leaves the product of both in viewprojection_matrix
 	updateViewMatrix();
 	updateProjectionMatrix();
-	viewprojection_matrix = view_matrix * projection_matrix;
 	return viewprojection_matrix;
 }
\ No newline at end of file